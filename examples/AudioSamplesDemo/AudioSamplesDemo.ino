@@ -10,6 +10,7 @@
  * 3. Different waveform types
  * 4. Audio sequences and patterns
  * 5. White noise generation
+ * 6. Non-blocking playback with completion callbacks
  * 
  * Hardware connections for MAX98357A:
  * - Connect amplifier DIN to GPIO25
@@ -238,6 +239,34 @@ void demonstrateVolumeControl() {
   }
 }
 
+void onSoundDone(int handle, AudioSamples::RequestState state, void* userData) {
+  Serial.printf("Request %d finished: %s\n", handle,
+                (state == AudioSamples::REQUEST_DONE) ? "done" :
+                (state == AudioSamples::REQUEST_CANCELLED) ? "cancelled" : "failed");
+}
+
+void demonstrateAsyncPlayback() {
+  Serial.println("=== Non-blocking Playback ===");
+
+  // Queued sounds play back to back while loop() keeps running
+  uint32_t start = micros();
+  audioSamples->playSampleAsync(AudioSamples::NOTIFICATION, 0.5f, onSoundDone);
+  audioSamples->playBeepAsync(600, 150, 0.5f, AudioSamples::TRIANGLE, onSoundDone);
+  int last = audioSamples->playSampleAsync(AudioSamples::SUCCESS, 0.5f, onSoundDone);
+  Serial.printf("Queued 3 sounds in %lu us\n", (unsigned long)(micros() - start));
+
+  while (audioSamples->getRequestState(last) == AudioSamples::REQUEST_QUEUED ||
+         audioSamples->getRequestState(last) == AudioSamples::REQUEST_PLAYING) {
+    delay(10);  // Free to do other work here
+  }
+
+  // Cancel a long sound halfway through
+  int alarm = audioSamples->playSampleAsync(AudioSamples::ALARM_SOFT, 0.5f, onSoundDone);
+  delay(500);
+  audioSamples->cancelRequest(alarm);
+  delay(500);
+}
+
 void setup() {
   Serial.begin(115200);
   delay(1000);
@@ -319,6 +348,9 @@ void loop() {
   demonstrateVolumeControl();
   delay(1000);
   
+  demonstrateAsyncPlayback();
+  delay(1000);
+  
   // End with power off sound
   Serial.println("Demonstration cycle complete!");
   audioSamples->playSample(AudioSamples::POWER_OFF, 0.5f);
@@ -0,0 +1,182 @@
+/**
+ * DspBenchmark.ino
+ * 
+ * Micro-benchmarks for the library's DSP kernels. No audio hardware is
+ * needed; results are printed to the serial monitor.
+ * 
+ * This example measures:
+ * 1. Q15 gain kernel, block (vector-friendly) path vs scalar path
+ * 2. Legacy float volume loop for reference
+ * 3. Wavetable oscillator vs libm sin(), including THD+N against an ideal sine
+ * 4. Polyphase resampler cost per channel at common rate pairs and qualities,
+ *    as cycles per output sample and MIPS needed to run in real time
+ * 
+ * The kernels have no Arduino dependency, so the same loops can be
+ * compiled and timed on a host machine.
+ * 
+ * Library: https://github.com/jahrulnr/esp32-speaker
+ */
+
+#include <Arduino.h>
+#include "GainKernel.h"
+#include "Oscillator.h"
+#include "Resampler.h"
+
+#define BENCH_SAMPLES 4608   // One stereo MP3 frame
+#define BENCH_ITERATIONS 200
+
+static int16_t srcBuffer[BENCH_SAMPLES];
+static int16_t dstBuffer[BENCH_SAMPLES];
+
+void printRate(const char* name, unsigned long elapsedUs, size_t samples) {
+  float samplesPerSecond = (elapsedUs > 0) ? (samples * 1e6f / elapsedUs) : 0.0f;
+  Serial.printf("%-28s %10.0f samples/s (%lu us)\n", name, samplesPerSecond, elapsedUs);
+}
+
+void benchmarkGain() {
+  Serial.println("=== Gain Kernel ===");
+  
+  const int32_t gainQ15 = GainKernel::toQ15(0.7f);
+  const size_t total = (size_t)BENCH_SAMPLES * BENCH_ITERATIONS;
+  
+  unsigned long start = micros();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    GainKernel::applyBlocks(srcBuffer, dstBuffer, BENCH_SAMPLES, gainQ15);
+  }
+  printRate("Q15 block path", micros() - start, total);
+  
+  start = micros();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    GainKernel::applyScalar(srcBuffer, dstBuffer, BENCH_SAMPLES, gainQ15);
+  }
+  printRate("Q15 scalar path", micros() - start, total);
+  
+  GainKernel ramped;
+  start = micros();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    ramped.setGain((i & 1) ? 0.3f : 0.9f); // Force a ramp on every call
+    ramped.process(srcBuffer, dstBuffer, BENCH_SAMPLES);
+  }
+  printRate("Q15 with ramping", micros() - start, total);
+  
+  const float volume = 0.7f;
+  start = micros();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (size_t n = 0; n < BENCH_SAMPLES; n++) {
+      dstBuffer[n] = (int16_t)(srcBuffer[n] * volume);
+    }
+  }
+  printRate("Float volume (legacy)", micros() - start, total);
+}
+
+void benchmarkOscillator() {
+  Serial.println("=== Sine Oscillator ===");
+  
+  const uint32_t sampleRate = 48000;
+  const float frequency = 1000.0f;
+  const size_t total = (size_t)BENCH_SAMPLES * BENCH_ITERATIONS;
+  
+  Oscillator oscillator(sampleRate, Oscillator::SINE);
+  oscillator.setFrequency(frequency);
+  oscillator.setAmplitude(1.0f);
+  
+  unsigned long start = micros();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    oscillator.render(dstBuffer, BENCH_SAMPLES);
+  }
+  printRate("Wavetable oscillator", micros() - start, total);
+  
+  // Legacy path: float phase computed as angularFreq * i, then fmod + sin
+  const float angularFreq = 2.0f * PI * frequency / sampleRate;
+  size_t n = 0;
+  start = micros();
+  for (int i = 0; i < BENCH_ITERATIONS; i++) {
+    for (size_t s = 0; s < BENCH_SAMPLES; s++, n++) {
+      float phase = fmod(angularFreq * n, 2.0f * PI);
+      dstBuffer[s] = (int16_t)(sin(phase) * 32767);
+    }
+  }
+  printRate("libm fmod + sin (legacy)", micros() - start, total);
+  
+  // THD+N: residual against a double-precision reference sine over one second
+  double legacyError = 0.0;
+  double wavetableError = 0.0;
+  double signal = 0.0;
+  oscillator.resetPhase();
+  for (uint32_t i = 0; i < sampleRate; i++) {
+    double reference = 32767.0 * sin(2.0 * M_PI * frequency * i / sampleRate);
+    double wavetable = oscillator.next();
+    double legacy = (int16_t)(sin(fmod(angularFreq * i, 2.0f * PI)) * 32767);
+    wavetableError += (wavetable - reference) * (wavetable - reference);
+    legacyError += (legacy - reference) * (legacy - reference);
+    signal += reference * reference;
+  }
+  Serial.printf("%-28s %10.1f dB\n", "THD+N wavetable", 10.0 * log10(wavetableError / signal));
+  Serial.printf("%-28s %10.1f dB\n", "THD+N libm (legacy)", 10.0 * log10(legacyError / signal));
+}
+
+void benchmarkResampler() {
+  Serial.println("=== Polyphase Resampler (per channel) ===");
+  
+  static const uint32_t ratePairs[][2] = {
+    {8000, 16000}, {22050, 16000}, {44100, 16000}, {48000, 16000},
+    {16000, 44100}, {22050, 44100}, {48000, 44100},
+    {8000, 48000}, {44100, 48000}
+  };
+  static const Resampler::Quality qualities[] = {
+    Resampler::QUALITY_LOW, Resampler::QUALITY_MEDIUM, Resampler::QUALITY_HIGH
+  };
+  const uint32_t cpuMhz = getCpuFrequencyMhz();
+  const int iterations = BENCH_ITERATIONS / 10;
+  
+  Resampler resampler;
+  for (size_t q = 0; q < sizeof(qualities) / sizeof(qualities[0]); q++) {
+    for (size_t r = 0; r < sizeof(ratePairs) / sizeof(ratePairs[0]); r++) {
+      uint32_t inRate = ratePairs[r][0];
+      uint32_t outRate = ratePairs[r][1];
+      if (!resampler.configure(inRate, outRate, 1, qualities[q])) {
+        continue;
+      }
+      
+      // Mono in/out: feed the source buffer and drain into the destination
+      size_t outputFrames = 0;
+      unsigned long start = micros();
+      for (int i = 0; i < iterations; i++) {
+        const int16_t* in = srcBuffer;
+        size_t framesLeft = BENCH_SAMPLES;
+        while (framesLeft > 0) {
+          size_t consumed = 0;
+          outputFrames += resampler.process(in, framesLeft, dstBuffer, BENCH_SAMPLES, &consumed);
+          in += consumed;
+          framesLeft -= consumed;
+        }
+      }
+      unsigned long elapsedUs = micros() - start;
+      
+      float cyclesPerSample = (outputFrames > 0) ? (float)elapsedUs * cpuMhz / outputFrames : 0.0f;
+      float mips = cyclesPerSample * outRate / 1e6f;
+      Serial.printf("%5lu -> %5lu Hz, %2u taps: %7.1f cycles/sample %6.2f MIPS\n",
+                    inRate, outRate, (unsigned)resampler.getTaps(), cyclesPerSample, mips);
+    }
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  Serial.println("\nDSP Kernel Benchmark");
+  Serial.println("====================");
+  
+  for (size_t i = 0; i < BENCH_SAMPLES; i++) {
+    srcBuffer[i] = (int16_t)random(-32768, 32767);
+  }
+}
+
+void loop() {
+  benchmarkGain();
+  benchmarkOscillator();
+  benchmarkResampler();
+  
+  Serial.println("--------------------");
+  delay(5000);
+}
@@ -117,11 +117,11 @@ void demonstrateVolumeControl() {
   
   Serial.println("Playing notification.mp3 with volume changes...");
   
-  // Start playback in a task so we can control volume
-  xTaskCreate([](void* parameter) {
-    MP3Player::playFile("/audio/notification.mp3", 0.5f);
-    vTaskDelete(NULL);
-  }, "MP3Playback", 8192, nullptr, 5, nullptr);
+  // Start asynchronous playback so we can control volume
+  if (!MP3Player::play("/audio/notification.mp3", 0.5f)) {
+    Serial.println("Playback failed");
+    return;
+  }
   
   // Change volume during playback
   delay(1000);
@@ -176,6 +176,36 @@ void demonstrateMultipleFiles() {
   }
 }
 
+void demonstrateGaplessPlaylist() {
+  Serial.println("=== Gapless Playlist ===");
+  
+  const char* playlist[] = {
+    "/audio/beep.mp3",
+    "/audio/startup.mp3", 
+    "/audio/notification.mp3"
+  };
+  
+  for (int i = 0; i < 3; i++) {
+    if (SPIFFS.exists(playlist[i])) {
+      MP3Player::enqueue(playlist[i]);
+    } else {
+      Serial.printf("File not found: %s\n", playlist[i]);
+    }
+  }
+  
+  Serial.printf("Playing %d queued files back to back...\n", (int)MP3Player::getQueueLength());
+  if (!MP3Player::playQueue(0.6f)) {
+    Serial.println("Nothing to play");
+    return;
+  }
+  
+  unsigned long startTime = millis();
+  while (MP3Player::isPlaying()) {
+    delay(100);
+  }
+  Serial.printf("Playlist completed in %ldms\n", millis() - startTime);
+}
+
 void demonstrateInterruptPlayback() {
   Serial.println("=== Playback Interruption Demo ===");
   
@@ -184,13 +214,12 @@ void demonstrateInterruptPlayback() {
     return;
   }
   
-  // Start playback in background task
-  xTaskCreate([](void* parameter) {
-    Serial.println("Starting background playback...");
-    MP3Player::playFile("/audio/startup.mp3", 0.6f);
-    Serial.println("Background playback finished");
-    vTaskDelete(NULL);
-  }, "BackgroundMP3", 8192, nullptr, 5, nullptr);
+  // Start playback in the background, play() returns immediately
+  Serial.println("Starting background playback...");
+  if (!MP3Player::play("/audio/startup.mp3", 0.6f)) {
+    Serial.println("Playback failed");
+    return;
+  }
   
   // Let it play for a bit
   delay(2000);
@@ -302,6 +331,9 @@ void loop() {
   demonstrateMultipleFiles();
   delay(2000);
   
+  demonstrateGaplessPlaylist();
+  delay(2000);
+  
   demonstrateInterruptPlayback();
   delay(2000);
   
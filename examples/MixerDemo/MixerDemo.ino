@@ -0,0 +1,94 @@
+/**
+ * MixerDemo.ino
+ * 
+ * Demonstration of AudioMixer: UI sounds play on top of MP3 music instead
+ * of waiting for it or corrupting it.
+ * 
+ * This example shows:
+ * 1. Handing the speaker to an AudioMixer
+ * 2. MP3 playback as a background voice
+ * 3. Alert sounds from AudioSamples as a higher-priority voice
+ * 4. Automatic ducking of the music while an alert plays
+ * 
+ * Hardware connections for MAX98357A:
+ * - Connect amplifier DIN to GPIO25
+ * - Connect amplifier BCLK to GPIO26
+ * - Connect amplifier LRCLK to GPIO27
+ * 
+ * SPIFFS files needed:
+ * - /audio/music.mp3
+ * 
+ * Library: https://github.com/jahrulnr/esp32-speaker
+ */
+
+#include <Arduino.h>
+#include <SPIFFS.h>
+#include "I2SSpeaker.h"
+#include "AudioMixer.h"
+#include "AudioSamples.h"
+#include "MP3Player.h"
+
+// Pin definitions
+#define I2S_DOUT_PIN GPIO_NUM_25
+#define I2S_BCLK_PIN GPIO_NUM_26
+#define I2S_LRC_PIN GPIO_NUM_27
+
+#define SAMPLE_RATE 22050
+
+I2SSpeaker* speaker = nullptr;
+AudioMixer* mixer = nullptr;
+AudioSamples* samples = nullptr;
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  Serial.println("\nAudio Mixer Demonstration");
+  Serial.println("=========================");
+  
+  if (!SPIFFS.begin(true)) {
+    Serial.println("Failed to mount SPIFFS");
+    while (1) { delay(100); }
+  }
+  
+  speaker = new I2SSpeaker(I2S_DOUT_PIN, I2S_BCLK_PIN, I2S_LRC_PIN);
+  esp_err_t err = speaker->init(SAMPLE_RATE, I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO);
+  if (err != ESP_OK) {
+    Serial.printf("Failed to initialize I2S speaker: %s\n", esp_err_to_name(err));
+    while (1) { delay(100); }
+  }
+  
+  // From here on only the mixer writes to the speaker
+  mixer = new AudioMixer(speaker);
+  if (!mixer->begin()) {
+    Serial.println("Failed to start mixer");
+    while (1) { delay(100); }
+  }
+  mixer->setDucking(0.25f); // Music at -12 dB while alerts play
+  
+  MP3Player::init(speaker);
+  MP3Player::setMixer(mixer, AudioMixer::PRIORITY_BACKGROUND);
+  
+  samples = new AudioSamples(speaker);
+  samples->setMixer(mixer, AudioMixer::PRIORITY_ALERT);
+  
+  Serial.println("Starting background music...");
+  if (!MP3Player::play("/audio/music.mp3", 0.6f)) {
+    Serial.println("Warning: /audio/music.mp3 not found, alerts only");
+  }
+}
+
+void loop() {
+  delay(4000);
+  
+  // Alerts start within one DMA frame and duck the music while they play
+  Serial.printf("Notification (%u voices active)\n", (unsigned)mixer->getActiveVoiceCount());
+  samples->playSample(AudioSamples::NOTIFICATION, 0.8f);
+  
+  delay(4000);
+  Serial.println("Double beep");
+  samples->playSample(AudioSamples::DOUBLE_BEEP, 0.8f);
+  
+  if (!MP3Player::isPlaying()) {
+    MP3Player::play("/audio/music.mp3", 0.6f);
+  }
+}
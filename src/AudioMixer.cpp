@@ -0,0 +1,288 @@
+#include "AudioMixer.h"
+#include <cstring>
+#include <esp_heap_caps.h>
+
+const char* AudioMixer::TAG = "AudioMixer";
+
+static const uint32_t REMOVE_POLL_MS = 1;
+static const uint32_t IDLE_WAIT_MS = 20;
+static const uint32_t END_TIMEOUT_MS = 500;
+
+AudioMixer::AudioMixer(I2SSpeaker* speaker)
+    : _speaker(speaker), _duckingGain(0.3f), _voiceBuffer(nullptr), _accumulator(nullptr),
+      _blockSamples(0), _task(nullptr), _stopped(nullptr), _running(false) {
+}
+
+AudioMixer::~AudioMixer() {
+    end();
+
+    if (_voiceBuffer) {
+        heap_caps_free(_voiceBuffer);
+        _voiceBuffer = nullptr;
+    }
+    if (_accumulator) {
+        heap_caps_free(_accumulator);
+        _accumulator = nullptr;
+    }
+    if (_stopped) {
+        vSemaphoreDelete(_stopped);
+    }
+}
+
+bool AudioMixer::begin(UBaseType_t taskPriority) {
+    if (_task) {
+        return true;
+    }
+
+    if (!_speaker || !_speaker->isInitialized()) {
+        ESP_LOGE(TAG, "Speaker not initialized");
+        return false;
+    }
+
+    if (!_stopped) {
+        _stopped = xSemaphoreCreateBinary();
+        if (!_stopped) {
+            return false;
+        }
+    }
+
+    // One block is one write slot of the speaker
+    size_t blockSamples = _speaker->getDmaConfig().framesPerDescriptor * _speaker->getChannelCount();
+    if (blockSamples != _blockSamples) {
+        if (_voiceBuffer) {
+            heap_caps_free(_voiceBuffer);
+        }
+        if (_accumulator) {
+            heap_caps_free(_accumulator);
+        }
+        _voiceBuffer = (int16_t*)heap_caps_malloc(blockSamples * sizeof(int16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        _accumulator = (int32_t*)heap_caps_malloc(blockSamples * sizeof(int32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (!_voiceBuffer || !_accumulator) {
+            ESP_LOGE(TAG, "Failed to allocate mix buffers (%u samples)", (unsigned)blockSamples);
+            _blockSamples = 0;
+            return false;
+        }
+        _blockSamples = blockSamples;
+    }
+
+    if (!_speaker->isActive() && _speaker->start() != ESP_OK) {
+        return false;
+    }
+
+    _running = true;
+    if (xTaskCreate(audioTask, "audio_mixer", TASK_STACK, this, taskPriority, (TaskHandle_t*)&_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create audio task");
+        _task = nullptr;
+        _running = false;
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Mixer started: %u voices, %u-sample blocks", (unsigned)MAX_VOICES, (unsigned)_blockSamples);
+    return true;
+}
+
+void AudioMixer::end() {
+    if (!_task) {
+        return;
+    }
+
+    _running = false;
+    xTaskNotifyGive(_task);
+
+    // Voices and mix buffers stay valid until the task has acknowledged the stop
+    while (xSemaphoreTake(_stopped, pdMS_TO_TICKS(END_TIMEOUT_MS)) != pdTRUE) {
+        ESP_LOGW(TAG, "Waiting for the audio task to stop");
+    }
+
+    for (size_t i = 0; i < MAX_VOICES; i++) {
+        _voices[i].state.store(VOICE_FREE, std::memory_order_release);
+    }
+}
+
+int AudioMixer::addVoice(AudioSource* source, float gain, uint8_t priority) {
+    if (!source) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < MAX_VOICES; i++) {
+        Voice& voice = _voices[i];
+        uint8_t expected = VOICE_FREE;
+        if (!voice.state.compare_exchange_strong(expected, VOICE_CLAIMED, std::memory_order_acquire)) {
+            continue;
+        }
+
+        voice.generation++;
+        voice.priority = priority;
+        voice.gain = constrain(gain, 0.0f, 2.0f);
+        voice.source = source;
+        voice.kernel.resetGain(voice.gain);
+        voice.state.store(VOICE_ACTIVE, std::memory_order_release);
+
+        // Wake the audio task if it is idle, so the voice starts next block
+        if (_task) {
+            xTaskNotifyGive(_task);
+        }
+        return (int)((voice.generation << 8) | i);
+    }
+
+    ESP_LOGW(TAG, "No free voice");
+    return -1;
+}
+
+AudioMixer::Voice* AudioMixer::lookup(int voice) const {
+    if (voice < 0) {
+        return nullptr;
+    }
+
+    size_t index = voice & 0xFF;
+    uint8_t generation = (uint8_t)((voice >> 8) & 0xFF);
+    if (index >= MAX_VOICES || _voices[index].generation != generation) {
+        return nullptr;
+    }
+    return const_cast<Voice*>(&_voices[index]);
+}
+
+bool AudioMixer::removeVoice(int voice, uint32_t timeoutMs) {
+    Voice* v = lookup(voice);
+    if (!v) {
+        return true;
+    }
+
+    uint8_t expected = VOICE_ACTIVE;
+    v->state.compare_exchange_strong(expected, VOICE_REMOVING, std::memory_order_acq_rel);
+
+    if (!_task) {
+        v->state.store(VOICE_FREE, std::memory_order_release);
+        return true;
+    }
+
+    // The audio task frees the voice at its next block
+    xTaskNotifyGive(_task);
+    uint32_t waited = 0;
+    while (v->state.load(std::memory_order_acquire) == VOICE_REMOVING && waited < timeoutMs) {
+        vTaskDelay(pdMS_TO_TICKS(REMOVE_POLL_MS));
+        waited += REMOVE_POLL_MS;
+    }
+
+    return v->state.load(std::memory_order_acquire) != VOICE_REMOVING;
+}
+
+bool AudioMixer::isVoiceActive(int voice) const {
+    Voice* v = lookup(voice);
+    return v && v->state.load(std::memory_order_acquire) == VOICE_ACTIVE;
+}
+
+void AudioMixer::setVoiceGain(int voice, float gain) {
+    Voice* v = lookup(voice);
+    if (v) {
+        v->gain = constrain(gain, 0.0f, 2.0f);
+    }
+}
+
+void AudioMixer::setDucking(float gain) {
+    _duckingGain = constrain(gain, 0.0f, 1.0f);
+}
+
+size_t AudioMixer::getActiveVoiceCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < MAX_VOICES; i++) {
+        if (_voices[i].state.load(std::memory_order_acquire) == VOICE_ACTIVE) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool AudioMixer::mixBlock() {
+    size_t capacity;
+    int16_t* slot = (int16_t*)_speaker->acquireBuffer(&capacity);
+    if (!slot) {
+        return false;
+    }
+
+    size_t channels = _speaker->getChannelCount();
+    size_t samples = _min(capacity / sizeof(int16_t), _blockSamples);
+    size_t frames = samples / channels;
+    samples = frames * channels;
+
+    memset(_accumulator, 0, samples * sizeof(int32_t));
+
+    // Voices below the highest active priority are ducked
+    uint8_t topPriority = 0;
+    for (size_t i = 0; i < MAX_VOICES; i++) {
+        if (_voices[i].state.load(std::memory_order_acquire) == VOICE_ACTIVE) {
+            topPriority = _max(topPriority, _voices[i].priority);
+        }
+    }
+    float duckingGain = _duckingGain;
+
+    for (size_t i = 0; i < MAX_VOICES; i++) {
+        Voice& voice = _voices[i];
+        uint8_t state = voice.state.load(std::memory_order_acquire);
+
+        if (state == VOICE_REMOVING) {
+            voice.state.store(VOICE_FREE, std::memory_order_release);
+            continue;
+        }
+        if (state != VOICE_ACTIVE) {
+            continue;
+        }
+
+        size_t rendered = voice.source->read(_voiceBuffer, frames);
+        size_t count = rendered * channels;
+
+        voice.kernel.setGain((voice.priority < topPriority) ? voice.gain * duckingGain : voice.gain);
+        voice.kernel.process(_voiceBuffer, _voiceBuffer, count);
+
+        for (size_t s = 0; s < count; s++) {
+            _accumulator[s] += _voiceBuffer[s];
+        }
+
+        if (rendered < frames && voice.source->isFinished()) {
+            voice.state.store(VOICE_FREE, std::memory_order_release);
+        }
+    }
+
+    // Saturate the sum once, straight into the write slot
+    for (size_t s = 0; s < samples; s++) {
+        int32_t value = _accumulator[s];
+        slot[s] = (int16_t)((value > 32767) ? 32767 : (value < -32768) ? -32768 : value);
+    }
+
+    return _speaker->commitBuffer(samples * sizeof(int16_t), 100);
+}
+
+void AudioMixer::audioTask(void* param) {
+    AudioMixer* mixer = static_cast<AudioMixer*>(param);
+    bool idle = true;
+
+    while (mixer->_running) {
+        bool busy = false;
+        for (size_t i = 0; i < MAX_VOICES; i++) {
+            uint8_t state = mixer->_voices[i].state.load(std::memory_order_acquire);
+            if (state == VOICE_ACTIVE || state == VOICE_REMOVING) {
+                busy = true;
+                break;
+            }
+        }
+
+        if (!busy) {
+            // Pad once when the last voice ends, then sleep until a voice is added
+            if (!idle) {
+                mixer->_speaker->clear();
+                idle = true;
+            }
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(IDLE_WAIT_MS));
+            continue;
+        }
+
+        idle = false;
+        if (!mixer->mixBlock()) {
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+
+    mixer->_task = nullptr;
+    xSemaphoreGive(mixer->_stopped);
+    vTaskDelete(nullptr);
+}
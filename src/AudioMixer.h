@@ -0,0 +1,169 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "I2SSpeaker.h"
+#include "AudioSource.h"
+#include "GainKernel.h"
+
+/**
+ * AudioMixer - software mixer that owns an I2SSpeaker
+ *
+ * Voices are AudioSource instances (MP3 streams, tones, PCM clips) mixed
+ * block by block on a dedicated audio task: each voice renders one block,
+ * its gain is applied with a click-free ramp, and the result is summed
+ * into an int32 accumulator that saturates once into the speaker's write
+ * slot. A block is one write slot (one DMA frame), so a voice added now is
+ * heard after at most one block on top of the DMA queue latency.
+ *
+ * Each voice has a priority. While any voice of higher priority is
+ * active, lower-priority voices are ducked by the ducking gain, so alerts
+ * stay audible over background music.
+ *
+ * Voices may be added, changed and removed from any task. Once a mixer is
+ * running, nothing else may write to its speaker.
+ */
+class AudioMixer {
+public:
+    static const size_t MAX_VOICES = 8;
+
+    static const uint8_t PRIORITY_BACKGROUND = 0;  // Music, ambience
+    static const uint8_t PRIORITY_NORMAL = 1;      // UI sounds
+    static const uint8_t PRIORITY_ALERT = 2;       // Alarms, notifications
+
+    static const uint32_t TASK_STACK = 4096;
+    static const UBaseType_t TASK_PRIORITY = 7;
+
+    /**
+     * Constructor
+     *
+     * @param speaker Pointer to initialized I2SSpeaker instance
+     */
+    AudioMixer(I2SSpeaker* speaker);
+
+    /**
+     * Destructor - stops the audio task
+     */
+    ~AudioMixer();
+
+    /**
+     * Allocate mix buffers, start the speaker and the audio task
+     *
+     * @param taskPriority FreeRTOS priority of the audio task
+     * @return true if the mixer is running
+     */
+    bool begin(UBaseType_t taskPriority = TASK_PRIORITY);
+
+    /**
+     * Stop the audio task and drop all voices
+     * 
+     * Blocks until the audio task has finished its current block.
+     */
+    void end();
+
+    /**
+     * Add a voice
+     *
+     * The source is pulled from the audio task until it finishes or the
+     * voice is removed; it must stay valid until then.
+     *
+     * @param source Source to mix
+     * @param gain Voice gain (0.0 to 2.0)
+     * @param priority Voice priority (PRIORITY_BACKGROUND..PRIORITY_ALERT or higher)
+     * @return Voice handle, or -1 if all voices are busy
+     */
+    int addVoice(AudioSource* source, float gain = 1.0f, uint8_t priority = PRIORITY_NORMAL);
+
+    /**
+     * Remove a voice and wait until the audio task has let go of its source
+     *
+     * @param voice Voice handle from addVoice()
+     * @param timeoutMs Maximum time to wait
+     * @return true if the source is no longer used
+     */
+    bool removeVoice(int voice, uint32_t timeoutMs = 100);
+
+    /**
+     * Check whether a voice is still playing
+     *
+     * @param voice Voice handle from addVoice()
+     * @return true until the source finished or the voice was removed
+     */
+    bool isVoiceActive(int voice) const;
+
+    /**
+     * Change the gain of a voice (ramped)
+     *
+     * @param voice Voice handle from addVoice()
+     * @param gain Voice gain (0.0 to 2.0)
+     */
+    void setVoiceGain(int voice, float gain);
+
+    /**
+     * Set gain applied to voices below the highest active priority
+     *
+     * @param gain Ducking gain (0.0 to 1.0, default 0.3)
+     */
+    void setDucking(float gain);
+
+    /**
+     * Get number of active voices
+     *
+     * @return Active voice count
+     */
+    size_t getActiveVoiceCount() const;
+
+    bool isRunning() const { return _task != nullptr; }
+
+    I2SSpeaker* getSpeaker() const { return _speaker; }
+
+private:
+    static const char* TAG;
+
+    enum VoiceState : uint8_t {
+        VOICE_FREE,
+        VOICE_CLAIMED,   // Being set up by addVoice()
+        VOICE_ACTIVE,
+        VOICE_REMOVING   // removeVoice() waits for the audio task to release it
+    };
+
+    struct Voice {
+        std::atomic<uint8_t> state;
+        uint8_t generation;
+        uint8_t priority;
+        volatile float gain;
+        AudioSource* source;
+        GainKernel kernel;
+
+        Voice() : state(VOICE_FREE), generation(0), priority(0), gain(1.0f), source(nullptr) {}
+    };
+
+    I2SSpeaker* _speaker;
+    Voice _voices[MAX_VOICES];
+    volatile float _duckingGain;
+
+    int16_t* _voiceBuffer;      // One block of one voice
+    int32_t* _accumulator;      // One block of the mix
+    size_t _blockSamples;
+
+    TaskHandle_t volatile _task;
+    SemaphoreHandle_t _stopped;   // Given by the audio task once it no longer touches voices or buffers
+    volatile bool _running;
+
+    /**
+     * Resolve a handle to its voice if the handle is still current
+     */
+    Voice* lookup(int voice) const;
+
+    /**
+     * Mix one block of all active voices into the speaker
+     *
+     * @return false on speaker error
+     */
+    bool mixBlock();
+
+    /**
+     * Audio task entry point
+     */
+    static void audioTask(void* param);
+};
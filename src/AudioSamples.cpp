@@ -1,16 +1,174 @@
 #include "AudioSamples.h"
+#include "GainKernel.h"
 #include <cmath>
 #include <cstdlib>
+#include <esp_heap_caps.h>
+
+// Preset note tables, one per SampleType:
+// {frequency, sweep target, duration ms, gap ms, waveform, gain}
+static constexpr NoteEvent PRESET_BEEP_SHORT[] = {
+    {1000, 0, 200, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_BEEP_LONG[] = {
+    {1000, 0, 500, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_DOUBLE_BEEP[] = {
+    {1000, 0, 150, 100, Oscillator::SINE, 1.0f},
+    {1000, 0, 150, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_TRIPLE_BEEP[] = {
+    {1000, 0, 100, 80, Oscillator::SINE, 1.0f},
+    {1000, 0, 100, 80, Oscillator::SINE, 1.0f},
+    {1000, 0, 100, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_CONFIRMATION[] = {
+    {800, 0, 150, 50, Oscillator::SINE, 1.0f},
+    {1200, 0, 200, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_ERROR[] = {
+    {400, 0, 300, 100, Oscillator::SINE, 1.0f},
+    {300, 0, 300, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_STARTUP[] = {    // C, E, G, C (octave higher)
+    {523, 0, 200, 50, Oscillator::SINE, 1.0f},
+    {659, 0, 200, 50, Oscillator::SINE, 1.0f},
+    {784, 0, 200, 50, Oscillator::SINE, 1.0f},
+    {1047, 0, 400, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_NOTIFICATION[] = {
+    {1000, 0, 100, 50, Oscillator::SINE, 1.0f},
+    {1500, 0, 100, 50, Oscillator::SINE, 1.0f},
+    {1000, 0, 100, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_ALARM_SOFT[] = {
+    {500, 800, 1000, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_ALARM_URGENT[] = {
+    {800, 1200, 500, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_CLICK[] = {
+    {2000, 0, 50, 0, Oscillator::SQUARE, 1.0f}
+};
+static constexpr NoteEvent PRESET_SUCCESS[] = {
+    {523, 0, 150, 30, Oscillator::SINE, 1.0f},
+    {659, 0, 150, 30, Oscillator::SINE, 1.0f},
+    {784, 0, 300, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_WARNING[] = {
+    {800, 0, 200, 50, Oscillator::SINE, 1.0f},
+    {600, 0, 200, 50, Oscillator::SINE, 1.0f},
+    {800, 0, 200, 50, Oscillator::SINE, 1.0f},
+    {600, 0, 200, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_POWER_ON[] = {
+    {300, 0, 100, 20, Oscillator::SINE, 1.0f},
+    {400, 0, 100, 20, Oscillator::SINE, 1.0f},
+    {500, 0, 100, 20, Oscillator::SINE, 1.0f},
+    {600, 0, 100, 20, Oscillator::SINE, 1.0f},
+    {700, 0, 100, 20, Oscillator::SINE, 1.0f},
+    {800, 0, 200, 0, Oscillator::SINE, 1.0f}
+};
+static constexpr NoteEvent PRESET_POWER_OFF[] = {
+    {800, 0, 100, 20, Oscillator::SINE, 1.0f},
+    {700, 0, 100, 20, Oscillator::SINE, 1.0f},
+    {600, 0, 100, 20, Oscillator::SINE, 1.0f},
+    {500, 0, 100, 20, Oscillator::SINE, 1.0f},
+    {400, 0, 100, 20, Oscillator::SINE, 1.0f},
+    {300, 0, 200, 0, Oscillator::SINE, 1.0f}
+};
+
+struct Preset {
+    const NoteEvent* notes;
+    size_t count;
+};
+
+#define PRESET(notes) { notes, sizeof(notes) / sizeof(notes[0]) }
+
+// Indexed by SampleType
+static constexpr Preset PRESETS[] = {
+    PRESET(PRESET_BEEP_SHORT),
+    PRESET(PRESET_BEEP_LONG),
+    PRESET(PRESET_DOUBLE_BEEP),
+    PRESET(PRESET_TRIPLE_BEEP),
+    PRESET(PRESET_CONFIRMATION),
+    PRESET(PRESET_ERROR),
+    PRESET(PRESET_STARTUP),
+    PRESET(PRESET_NOTIFICATION),
+    PRESET(PRESET_ALARM_SOFT),
+    PRESET(PRESET_ALARM_URGENT),
+    PRESET(PRESET_CLICK),
+    PRESET(PRESET_SUCCESS),
+    PRESET(PRESET_WARNING),
+    PRESET(PRESET_POWER_ON),
+    PRESET(PRESET_POWER_OFF)
+};
+
+#undef PRESET
+
+static_assert(sizeof(PRESETS) / sizeof(PRESETS[0]) == AudioSamples::SAMPLE_TYPE_COUNT,
+              "PRESETS must have one entry per SampleType");
+
+static const uint32_t IDLE_WAIT_MS = 50;
+
+namespace {
+
+/**
+ * Holds the render lock for the lifetime of a scope
+ */
+class RenderGuard {
+public:
+    RenderGuard(SemaphoreHandle_t lock) : _lock(lock) {
+        if (_lock) {
+            xSemaphoreTakeRecursive(_lock, portMAX_DELAY);
+        }
+    }
+
+    ~RenderGuard() {
+        if (_lock) {
+            xSemaphoreGiveRecursive(_lock);
+        }
+    }
+
+private:
+    SemaphoreHandle_t _lock;
+};
+
+}
 
 AudioSamples::AudioSamples(I2SSpeaker* speaker) 
-    : _speaker(speaker), _sampleRate(16000) {
+    : _speaker(speaker), _sampleRate(16000), _resamplerQuality(Resampler::QUALITY_LOW),
+      _mixer(nullptr), _mixerPriority(AudioMixer::PRIORITY_ALERT), _capture(nullptr),
+      _requestQueue(nullptr), _asyncTask(nullptr), _asyncStopped(nullptr), _asyncStarted(false), _asyncRunning(false),
+      _cancel(nullptr) {
     if (_speaker && _speaker->isInitialized()) {
         _sampleRate = _speaker->getSampleRate();
     }
+    _renderLock = xSemaphoreCreateRecursiveMutex();
 }
 
 AudioSamples::~AudioSamples() {
-    // No cleanup needed - we don't own the speaker
+    // We don't own the speaker; only stop the audio task
+    if (_asyncTask) {
+        cancelAllRequests();
+        _asyncRunning = false;
+
+        // The task may be inside a render that blocks on the speaker; the
+        // queue, render lock and slots stay valid until it has exited
+        xSemaphoreTake(_asyncStopped, portMAX_DELAY);
+    }
+
+    if (_requestQueue) {
+        vQueueDelete(_requestQueue);
+        _requestQueue = nullptr;
+    }
+    if (_renderLock) {
+        vSemaphoreDelete(_renderLock);
+        _renderLock = nullptr;
+    }
+    if (_asyncStopped) {
+        vSemaphoreDelete(_asyncStopped);
+        _asyncStopped = nullptr;
+    }
 }
 
 bool AudioSamples::playSample(SampleType sampleType, float volume) {
@@ -21,296 +179,610 @@ bool AudioSamples::playSample(SampleType sampleType, float volume) {
     // Constrain volume
     volume = constrain(volume, 0.0f, 1.0f);
 
-    switch (sampleType) {
-        case BEEP_SHORT:
-            return playBeep(1000, 200, volume);
+    RenderGuard guard(_renderLock);
+    if (_cache.isEnabled()) {
+        size_t frames;
+        const int16_t* clip = cachedSample(sampleType, &frames);
+        if (clip) {
+            size_t channels = _speaker->getChannelCount();
+            if (_pcmSource.open(clip, frames, _sampleRate, channels, _sampleRate, channels)) {
+                return playSource(&_pcmSource, volume);
+            }
+        }
+    }
 
-        case BEEP_LONG:
-            return playBeep(1000, 500, volume);
+    size_t count;
+    const NoteEvent* notes = getPreset(sampleType, &count);
+    return notes && playSequence(notes, count, volume);
+}
 
-        case DOUBLE_BEEP: {
-            bool result = playBeep(1000, 150, volume);
-            delay(100);
-            return result && playBeep(1000, 150, volume);
-        }
+bool AudioSamples::playBeep(int frequency, int duration, float volume, WaveformType waveform) {
+    if (!isReady()) {
+        return false;
+    }
 
-        case TRIPLE_BEEP: {
-            bool result = playBeep(1000, 100, volume);
-            delay(80);
-            result = result && playBeep(1000, 100, volume);
-            delay(80);
-            return result && playBeep(1000, 100, volume);
-        }
+    size_t frames = (_sampleRate * duration) / 1000;
+    size_t fadeFrames = min(frames / 20, (size_t)(_sampleRate * 0.005)); // 5ms or 5% of duration
 
-        case CONFIRMATION: {
-            int frequencies[] = {800, 1200};
-            int durations[] = {150, 200};
-            return playToneSequence(frequencies, durations, 2, volume, 50);
-        }
+    Oscillator oscillator(_sampleRate, toOscillatorWaveform(waveform));
+    oscillator.setAmplitude(volume);
+    oscillator.setFrequency(frequency);
 
-        case ERROR: {
-            int frequencies[] = {400, 300};
-            int durations[] = {300, 300};
-            return playToneSequence(frequencies, durations, 2, volume, 100);
-        }
+    return streamOscillators(&oscillator, 1, frames, fadeFrames);
+}
 
-        case STARTUP: {
-            // Play startup melody: C, E, G, C (octave higher)
-            int frequencies[] = {523, 659, 784, 1047};
-            int durations[] = {200, 200, 200, 400};
-            return playToneSequence(frequencies, durations, 4, volume, 50);
-        }
+bool AudioSamples::playToneSequence(const int* frequencies, const int* durations, 
+                                   int count, float volume, int pauseBetween) {
+    if (!isReady() || !frequencies || !durations || count <= 0) {
+        return false;
+    }
 
-        case NOTIFICATION: {
-            int frequencies[] = {1000, 1500, 1000};
-            int durations[] = {100, 100, 100};
-            return playToneSequence(frequencies, durations, 3, volume, 50);
-        }
+    NoteEvent* notes = (NoteEvent*)malloc(count * sizeof(NoteEvent));
+    if (!notes) {
+        return false;
+    }
 
-        case ALARM_SOFT:
-            return playFrequencySweep(500, 800, 1000, volume);
+    for (int i = 0; i < count; i++) {
+        notes[i].frequency = (uint16_t)constrain(frequencies[i], 0, 65535);
+        notes[i].endFrequency = 0;
+        notes[i].durationMs = (uint16_t)constrain(durations[i], 0, 65535);
+        notes[i].gapMs = (i < count - 1) ? (uint16_t)constrain(pauseBetween, 0, 65535) : 0;
+        notes[i].waveform = Oscillator::SINE;
+        notes[i].gain = 1.0f;
+    }
 
-        case ALARM_URGENT:
-            return playFrequencySweep(800, 1200, 500, volume);
+    bool result = playSequence(notes, count, volume);
+    free(notes);
+    return result;
+}
 
-        case CLICK:
-            return playBeep(2000, 50, volume, SQUARE);
+bool AudioSamples::playSequence(const NoteEvent* notes, size_t count, float volume) {
+    if (!isReady() || !notes || count == 0) {
+        return false;
+    }
 
-        case SUCCESS: {
-            int frequencies[] = {523, 659, 784};
-            int durations[] = {150, 150, 300};
-            return playToneSequence(frequencies, durations, 3, volume, 30);
-        }
+    SequenceSource sequence(notes, count, _sampleRate, _speaker->getChannelCount());
+    return playSource(&sequence, constrain(volume, 0.0f, 1.0f));
+}
 
-        case WARNING: {
-            int frequencies[] = {800, 600, 800, 600};
-            int durations[] = {200, 200, 200, 200};
-            return playToneSequence(frequencies, durations, 4, volume, 50);
-        }
+const NoteEvent* AudioSamples::getPreset(SampleType sampleType, size_t* count) {
+    if (sampleType < 0 || sampleType >= SAMPLE_TYPE_COUNT) {
+        return nullptr;
+    }
+    if (count) {
+        *count = PRESETS[sampleType].count;
+    }
+    return PRESETS[sampleType].notes;
+}
 
-        case POWER_ON: {
-            int frequencies[] = {300, 400, 500, 600, 700, 800};
-            int durations[] = {100, 100, 100, 100, 100, 200};
-            return playToneSequence(frequencies, durations, 6, volume, 20);
-        }
+bool AudioSamples::playDTMF(char digit, int duration, float volume) {
+    int lowFreq, highFreq;
+    if (!getDTMFFrequencies(digit, &lowFreq, &highFreq)) {
+        return false;
+    }
 
-        case POWER_OFF: {
-            int frequencies[] = {800, 700, 600, 500, 400, 300};
-            int durations[] = {100, 100, 100, 100, 100, 200};
-            return playToneSequence(frequencies, durations, 6, volume, 20);
-        }
+    if (!isReady()) {
+        return false;
+    }
 
-        default:
-            return false;
+    size_t frames = (_sampleRate * duration) / 1000;
+    size_t fadeFrames = min(frames / 40, (size_t)(_sampleRate * 0.002)); // 2ms fade
+
+    // Each tone at half amplitude to prevent clipping when mixing
+    Oscillator tones[2] = {
+        Oscillator(_sampleRate, Oscillator::SINE),
+        Oscillator(_sampleRate, Oscillator::SINE)
+    };
+    tones[0].setAmplitude(volume * 0.5f);
+    tones[0].setFrequency(lowFreq);
+    tones[1].setAmplitude(volume * 0.5f);
+    tones[1].setFrequency(highFreq);
+
+    return streamOscillators(tones, 2, frames, fadeFrames);
+}
+
+bool AudioSamples::playWhiteNoise(int duration, float volume) {
+    if (!isReady()) {
+        return false;
     }
+
+    size_t frames = (_sampleRate * duration) / 1000;
+    size_t fadeFrames = min(frames / 20, (size_t)(_sampleRate * 0.01)); // 10ms fade
+
+    Oscillator noise(_sampleRate, Oscillator::NOISE);
+    noise.setAmplitude(volume);
+
+    return streamOscillators(&noise, 1, frames, fadeFrames);
 }
 
-bool AudioSamples::playBeep(int frequency, int duration, float volume, WaveformType waveform) {
+bool AudioSamples::playFrequencySweep(int startFreq, int endFreq, int duration, float volume) {
     if (!isReady()) {
         return false;
     }
 
-    // Calculate buffer size
-    size_t channelCount = (_speaker->getChannelMode() == I2S_SLOT_MODE_STEREO) ? 2 : 1;
-    size_t samplesNeeded = (_sampleRate * duration) / 1000;
-    size_t totalSamples = samplesNeeded * channelCount;
+    size_t frames = (_sampleRate * duration) / 1000;
+    size_t fadeFrames = min(frames / 20, (size_t)(_sampleRate * 0.01)); // 10ms fade
+
+    // Linear chirp from start to end frequency
+    Oscillator oscillator(_sampleRate, Oscillator::SINE);
+    oscillator.setAmplitude(volume);
+    oscillator.setFrequency(startFreq);
+    oscillator.sweepTo(endFreq, frames);
 
-    // Allocate buffer
-    int16_t* buffer = (int16_t*)malloc(totalSamples * sizeof(int16_t));
-    if (!buffer) {
+    return streamOscillators(&oscillator, 1, frames, fadeFrames);
+}
+
+bool AudioSamples::streamOscillators(Oscillator* oscillators, size_t oscillatorCount,
+                                     size_t frames, size_t fadeFrames) {
+    if (!oscillators || oscillatorCount == 0 || frames == 0) {
         return false;
     }
 
-    // Generate waveform
-    size_t samplesGenerated = generateWaveform(frequency, duration, volume, 
-                                              waveform, buffer, totalSamples);
+    ToneSource tone(oscillators, oscillatorCount, frames, fadeFrames, _speaker->getChannelCount());
+    return playSource(&tone, 1.0f);
+}
+
+bool AudioSamples::playSource(AudioSource* source, float volume) {
+    RenderGuard guard(_renderLock);
 
-    // Apply fade to prevent clicks
-    size_t fadeLength = min(samplesNeeded / 20, (size_t)(_sampleRate * 0.005)); // 5ms or 5% of duration
-    applyFade(buffer, samplesGenerated, fadeLength * channelCount, fadeLength * channelCount);
+    if (_capture) {
+        return renderTo(_capture, source, volume);
+    }
 
-    // Play the samples
-    bool result = false;
-    if (samplesGenerated > 0) {
-        if (!_speaker->isActive()) {
-            _speaker->start();
+    if (_mixer) {
+        // The mixer owns the speaker: play as a voice and wait for it to finish
+        int voice = _mixer->addVoice(source, volume, _mixerPriority);
+        if (voice < 0) {
+            return false;
         }
-        
-        int samplesWritten = _speaker->writeSamples(buffer, samplesGenerated, 1000);
-        result = (samplesWritten > 0);
+        while (_mixer->isVoiceActive(voice)) {
+            if (_cancel && *_cancel) {
+                // The source is the caller's, and the next request may reuse it:
+                // keep waiting until the mixer has let go of it
+                while (!_mixer->removeVoice(voice)) {
+                }
+                return false;
+            }
+            vTaskDelay(pdMS_TO_TICKS(VOICE_POLL_MS));
+        }
+        return true;
     }
 
-    free(buffer);
-    _speaker->clear();
+    if (!_speaker->isActive()) {
+        _speaker->start();
+    }
+
+    bool result = renderTo(_speaker, source, volume, _cancel);
+
+    // Queued requests play back to back; only drain once nothing else is waiting
+    if (!_cancel || uxQueueMessagesWaiting(_requestQueue) == 0) {
+        _speaker->clear();
+    }
     return result;
 }
 
-bool AudioSamples::playToneSequence(const int* frequencies, const int* durations, 
-                                   int count, float volume, int pauseBetween) {
-    if (!isReady() || !frequencies || !durations || count <= 0) {
+bool AudioSamples::renderTo(AudioSink* sink, AudioSource* source, float volume,
+                            const volatile bool* cancel) {
+    size_t channelCount = sink->getChannelCount();
+    size_t frameBytes = channelCount * sizeof(int16_t);
+    int32_t gainQ15 = GainKernel::toQ15(volume);
+
+    // Render block by block straight into the sink's write slot, so memory
+    // use does not depend on duration and output starts after one block
+    while (!source->isFinished()) {
+        if (cancel && *cancel) {
+            return false;
+        }
+
+        size_t capacity;
+        int16_t* block = (int16_t*)sink->acquireBuffer(&capacity, 1000);
+        if (!block) {
+            return false;
+        }
+
+        size_t blockFrames = _min(capacity / frameBytes, (size_t)RENDER_BLOCK_FRAMES);
+        size_t rendered = source->read(block, blockFrames);
+        if (gainQ15 != GainKernel::UNITY_Q15) {
+            GainKernel::applyBlocks(block, block, rendered * channelCount, gainQ15);
+        }
+
+        if (!sink->commitBuffer(rendered * frameBytes, 1000)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const int16_t* AudioSamples::cachedSample(SampleType sampleType, size_t* frames) {
+    size_t channels = _speaker->getChannelCount();
+    const int16_t* clip = _cache.find(sampleType, _sampleRate, channels, frames);
+    if (clip || !renderToCache(sampleType)) {
+        return clip;
+    }
+    return _cache.find(sampleType, _sampleRate, channels, frames);
+}
+
+bool AudioSamples::renderToCache(SampleType sampleType) {
+    size_t channels = _speaker->getChannelCount();
+    MemoryAudioSink recording(_sampleRate, channels);
+
+    size_t count;
+    const NoteEvent* notes = getPreset(sampleType, &count);
+    if (!notes) {
         return false;
     }
 
-    bool allSuccess = true;
-    for (int i = 0; i < count; i++) {
-        bool success = playBeep(frequencies[i], durations[i], volume);
-        allSuccess = allSuccess && success;
-        
-        if (i < count - 1 && pauseBetween > 0) {
-            delay(pauseBetween);
+    _capture = &recording;
+    bool rendered = playSequence(notes, count, 1.0f);
+    _capture = nullptr;
+
+    size_t frames = recording.getFrames();
+    int16_t* pcm = rendered ? recording.release() : nullptr;
+    if (!pcm) {
+        return false;
+    }
+
+    if (!_cache.insert(sampleType, _sampleRate, channels, pcm, frames)) {
+        heap_caps_free(pcm);
+        return false;
+    }
+    return true;
+}
+
+void AudioSamples::enableCache(size_t budgetBytes) {
+    RenderGuard guard(_renderLock);
+    _cache.setBudget(budgetBytes);
+}
+
+void AudioSamples::disableCache() {
+    RenderGuard guard(_renderLock);
+    _cache.clear();
+    _cache.setBudget(0);
+}
+
+size_t AudioSamples::preloadSamples() {
+    if (!isReady() || !_cache.isEnabled()) {
+        return 0;
+    }
+
+    RenderGuard guard(_renderLock);
+    size_t channels = _speaker->getChannelCount();
+    size_t cached = 0;
+    for (int type = 0; type < SAMPLE_TYPE_COUNT; type++) {
+        if (_cache.contains(type, _sampleRate, channels) || renderToCache((SampleType)type)) {
+            cached++;
         }
     }
+    return cached;
+}
 
-    return allSuccess;
+SampleCache::Stats AudioSamples::getCacheStats() const {
+    return _cache.getStats();
 }
 
-bool AudioSamples::playDTMF(char digit, int duration, float volume) {
-    int lowFreq, highFreq;
-    if (!getDTMFFrequencies(digit, &lowFreq, &highFreq)) {
+bool AudioSamples::playPCM(const int16_t* samples, size_t frames, uint32_t sampleRate,
+                           size_t channels, float volume) {
+    if (!isReady() || !samples || frames == 0) {
         return false;
     }
 
-    if (!isReady()) {
+    // Converted block by block to the speaker's format as it is played
+    RenderGuard guard(_renderLock);
+    if (!_pcmSource.open(samples, frames, sampleRate, channels, _speaker->getSampleRate(),
+                         _speaker->getChannelCount(), _resamplerQuality)) {
         return false;
     }
 
-    // Calculate buffer size
-    size_t channelCount = (_speaker->getChannelMode() == I2S_SLOT_MODE_STEREO) ? 2 : 1;
-    size_t samplesNeeded = (_sampleRate * duration) / 1000;
-    size_t totalSamples = samplesNeeded * channelCount;
+    return playSource(&_pcmSource, constrain(volume, 0.0f, 1.0f));
+}
 
-    // Allocate buffer
-    int16_t* buffer = (int16_t*)malloc(totalSamples * sizeof(int16_t));
-    if (!buffer) {
-        return false;
+void AudioSamples::setResamplerQuality(Resampler::Quality quality) {
+    _resamplerQuality = quality;
+}
+
+void AudioSamples::setMixer(AudioMixer* mixer, uint8_t priority) {
+    _mixer = mixer;
+    _mixerPriority = priority;
+}
+
+int AudioSamples::playSampleAsync(SampleType sampleType, float volume,
+                                  CompletionCallback callback, void* userData) {
+    Request* request = claimRequest(KIND_SAMPLE, volume, callback, userData);
+    if (!request) {
+        return -1;
     }
+    request->sampleType = sampleType;
+    return submitRequest(request);
+}
 
-    // Generate dual tone
-    size_t samplesGenerated = generateDualTone(lowFreq, highFreq, duration, volume, 
-                                              buffer, totalSamples);
+int AudioSamples::playBeepAsync(int frequency, int duration, float volume, WaveformType waveform,
+                                CompletionCallback callback, void* userData) {
+    Request* request = claimRequest(KIND_BEEP, volume, callback, userData);
+    if (!request) {
+        return -1;
+    }
+    request->frequency = frequency;
+    request->duration = duration;
+    request->waveform = waveform;
+    return submitRequest(request);
+}
 
-    // Apply fade
-    size_t fadeLength = min(samplesNeeded / 40, (size_t)(_sampleRate * 0.002)); // 2ms fade
-    applyFade(buffer, samplesGenerated, fadeLength * channelCount, fadeLength * channelCount);
+int AudioSamples::playSequenceAsync(const NoteEvent* notes, size_t count, float volume,
+                                    CompletionCallback callback, void* userData) {
+    if (!notes || count == 0) {
+        return -1;
+    }
 
-    // Play the samples
-    bool result = false;
-    if (samplesGenerated > 0) {
-        if (!_speaker->isActive()) {
-            _speaker->start();
-        }
-        
-        int samplesWritten = _speaker->writeSamples(buffer, samplesGenerated, 1000);
-        result = (samplesWritten > 0);
+    Request* request = claimRequest(KIND_SEQUENCE, volume, callback, userData);
+    if (!request) {
+        return -1;
     }
+    request->notes = notes;
+    request->count = count;
+    return submitRequest(request);
+}
 
-    free(buffer);
-    _speaker->clear();
-    return result;
+int AudioSamples::playDTMFAsync(char digit, int duration, float volume,
+                                CompletionCallback callback, void* userData) {
+    Request* request = claimRequest(KIND_DTMF, volume, callback, userData);
+    if (!request) {
+        return -1;
+    }
+    request->digit = digit;
+    request->duration = duration;
+    return submitRequest(request);
 }
 
-bool AudioSamples::playWhiteNoise(int duration, float volume) {
+int AudioSamples::playWhiteNoiseAsync(int duration, float volume,
+                                      CompletionCallback callback, void* userData) {
+    Request* request = claimRequest(KIND_NOISE, volume, callback, userData);
+    if (!request) {
+        return -1;
+    }
+    request->duration = duration;
+    return submitRequest(request);
+}
+
+int AudioSamples::playFrequencySweepAsync(int startFreq, int endFreq, int duration, float volume,
+                                          CompletionCallback callback, void* userData) {
+    Request* request = claimRequest(KIND_SWEEP, volume, callback, userData);
+    if (!request) {
+        return -1;
+    }
+    request->frequency = startFreq;
+    request->endFrequency = endFreq;
+    request->duration = duration;
+    return submitRequest(request);
+}
+
+AudioSamples::Request* AudioSamples::claimRequest(RequestKind kind, float volume,
+                                                  CompletionCallback callback, void* userData) {
     if (!isReady()) {
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < MAX_REQUESTS; i++) {
+        Request& request = _requests[i];
+        uint8_t expected = SLOT_FREE;
+        if (!request.state.compare_exchange_strong(expected, SLOT_CLAIMED, std::memory_order_acquire)) {
+            continue;
+        }
+
+        // New generation first: cancelRequest() rechecks it after raising the flag
+        request.generation++;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        request.cancel = false;
+        request.result = REQUEST_UNKNOWN;
+        request.kind = kind;
+        request.volume = volume;
+        request.callback = callback;
+        request.userData = userData;
+        return &request;
+    }
+
+    return nullptr;
+}
+
+int AudioSamples::submitRequest(Request* request) {
+    uint8_t index = (uint8_t)(request - _requests);
+    int handle = (int)((request->generation << 8) | index);
+
+    if (!startAsyncTask()) {
+        request->result = REQUEST_FAILED;
+        request->state.store(SLOT_FREE, std::memory_order_release);
+        return -1;
+    }
+
+    // The queue holds MAX_REQUESTS entries, one per slot, so this never waits
+    request->state.store(SLOT_QUEUED, std::memory_order_release);
+    if (xQueueSend(_requestQueue, &index, 0) != pdTRUE) {
+        request->result = REQUEST_FAILED;
+        request->state.store(SLOT_FREE, std::memory_order_release);
+        return -1;
+    }
+
+    return handle;
+}
+
+AudioSamples::Request* AudioSamples::lookupRequest(int handle) const {
+    if (handle < 0) {
+        return nullptr;
+    }
+
+    size_t index = handle & 0xFF;
+    uint8_t generation = (uint8_t)((handle >> 8) & 0xFF);
+    if (index >= MAX_REQUESTS || _requests[index].generation != generation) {
+        return nullptr;
+    }
+    return const_cast<Request*>(&_requests[index]);
+}
+
+AudioSamples::RequestState AudioSamples::getRequestState(int handle) const {
+    Request* request = lookupRequest(handle);
+    if (!request) {
+        return REQUEST_UNKNOWN;
+    }
+
+    switch (request->state.load(std::memory_order_acquire)) {
+        case SLOT_CLAIMED:
+        case SLOT_QUEUED:
+            return REQUEST_QUEUED;
+        case SLOT_PLAYING:
+            return REQUEST_PLAYING;
+        default:
+            return (RequestState)request->result;
+    }
+}
+
+bool AudioSamples::cancelRequest(int handle) {
+    Request* request = lookupRequest(handle);
+    if (!request) {
         return false;
     }
 
-    // Calculate buffer size
-    size_t channelCount = (_speaker->getChannelMode() == I2S_SLOT_MODE_STEREO) ? 2 : 1;
-    size_t samplesNeeded = (_sampleRate * duration) / 1000;
-    size_t totalSamples = samplesNeeded * channelCount;
+    uint8_t state = request->state.load(std::memory_order_acquire);
+    if (state != SLOT_QUEUED && state != SLOT_PLAYING) {
+        return false;
+    }
 
-    // Allocate buffer
-    int16_t* buffer = (int16_t*)malloc(totalSamples * sizeof(int16_t));
-    if (!buffer) {
+    request->cancel = true;
+
+    // The slot may have been freed and claimed again since the check above;
+    // the new request must not inherit the flag
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (lookupRequest(handle) != request) {
+        request->cancel = false;
         return false;
     }
+    return true;
+}
 
-    // Generate white noise
-    int16_t maxAmplitude = (int16_t)(volume * 32767);
-    for (size_t i = 0; i < samplesNeeded; i++) {
-        int16_t sample = (int16_t)((random(65536) - 32768) * volume);
-        
-        // Fill all channels
-        for (size_t ch = 0; ch < channelCount; ch++) {
-            buffer[i * channelCount + ch] = sample;
+void AudioSamples::cancelAllRequests() {
+    for (size_t i = 0; i < MAX_REQUESTS; i++) {
+        uint8_t state = _requests[i].state.load(std::memory_order_acquire);
+        if (state == SLOT_QUEUED || state == SLOT_PLAYING) {
+            _requests[i].cancel = true;
         }
     }
+}
 
-    // Apply fade to prevent clicks
-    size_t fadeLength = min(samplesNeeded / 20, (size_t)(_sampleRate * 0.01)); // 10ms fade
-    applyFade(buffer, totalSamples, fadeLength * channelCount, fadeLength * channelCount);
+size_t AudioSamples::getPendingRequestCount() const {
+    size_t count = 0;
+    for (size_t i = 0; i < MAX_REQUESTS; i++) {
+        uint8_t state = _requests[i].state.load(std::memory_order_acquire);
+        if (state == SLOT_QUEUED || state == SLOT_PLAYING) {
+            count++;
+        }
+    }
+    return count;
+}
 
-    // Play the samples
-    bool result = false;
-    if (!_speaker->isActive()) {
-        _speaker->start();
+bool AudioSamples::runRequest(const Request& request) {
+    RenderGuard guard(_renderLock);
+    _cancel = &request.cancel;
+
+    bool result;
+    switch (request.kind) {
+        case KIND_SAMPLE:
+            result = playSample(request.sampleType, request.volume);
+            break;
+        case KIND_BEEP:
+            result = playBeep(request.frequency, request.duration, request.volume, request.waveform);
+            break;
+        case KIND_SEQUENCE:
+            result = playSequence(request.notes, request.count, request.volume);
+            break;
+        case KIND_DTMF:
+            result = playDTMF(request.digit, request.duration, request.volume);
+            break;
+        case KIND_NOISE:
+            result = playWhiteNoise(request.duration, request.volume);
+            break;
+        case KIND_SWEEP:
+            result = playFrequencySweep(request.frequency, request.endFrequency,
+                                        request.duration, request.volume);
+            break;
+        default:
+            result = false;
+            break;
     }
-    
-    int samplesWritten = _speaker->writeSamples(buffer, totalSamples, 1000);
-    result = (samplesWritten > 0);
 
-    free(buffer);
-    _speaker->clear();
+    _cancel = nullptr;
     return result;
 }
 
-bool AudioSamples::playFrequencySweep(int startFreq, int endFreq, int duration, float volume) {
-    if (!isReady()) {
-        return false;
+bool AudioSamples::startAsyncTask() {
+    // Only the first caller creates the task; racing callers see no queue yet
+    // and are rejected rather than made to wait
+    bool expected = false;
+    if (!_asyncStarted.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        return _requestQueue != nullptr && _asyncTask != nullptr;
     }
 
-    // Calculate buffer size
-    size_t channelCount = (_speaker->getChannelMode() == I2S_SLOT_MODE_STEREO) ? 2 : 1;
-    size_t samplesNeeded = (_sampleRate * duration) / 1000;
-    size_t totalSamples = samplesNeeded * channelCount;
+    if (!_asyncStopped) {
+        _asyncStopped = xSemaphoreCreateBinary();
+    }
+    QueueHandle_t queue = _asyncStopped ? xQueueCreate(MAX_REQUESTS, sizeof(uint8_t)) : nullptr;
+    if (!queue) {
+        _asyncStarted.store(false, std::memory_order_release);
+        return false;
+    }
 
-    // Allocate buffer
-    int16_t* buffer = (int16_t*)malloc(totalSamples * sizeof(int16_t));
-    if (!buffer) {
+    _requestQueue = queue;
+    _asyncRunning = true;
+    TaskHandle_t task = nullptr;
+    if (xTaskCreate(asyncTask, "audio_samples", ASYNC_TASK_STACK, this, ASYNC_TASK_PRIORITY, &task) != pdPASS) {
+        _requestQueue = nullptr;
+        vQueueDelete(queue);
+        _asyncRunning = false;
+        _asyncStarted.store(false, std::memory_order_release);
         return false;
     }
+    _asyncTask = task;
+    return true;
+}
 
-    // Generate frequency sweep
-    int16_t maxAmplitude = (int16_t)(volume * 32767);
-    float phase = 0.0f;
-    
-    for (size_t i = 0; i < samplesNeeded; i++) {
-        // Calculate current frequency (linear interpolation)
-        float t = (float)i / samplesNeeded;
-        float currentFreq = startFreq + (endFreq - startFreq) * t;
-        
-        // Generate sample
-        float sineValue = sin(phase);
-        int16_t sample = (int16_t)(sineValue * maxAmplitude);
-        
-        // Update phase
-        phase += 2.0f * PI * currentFreq / _sampleRate;
-        if (phase >= 2.0f * PI) {
-            phase -= 2.0f * PI;
+void AudioSamples::asyncTask(void* param) {
+    AudioSamples* samples = static_cast<AudioSamples*>(param);
+
+    while (true) {
+        uint8_t index;
+        bool running = samples->_asyncRunning;
+        if (xQueueReceive(samples->_requestQueue, &index, running ? pdMS_TO_TICKS(IDLE_WAIT_MS) : 0) != pdTRUE) {
+            if (!running) {
+                break;
+            }
+            continue;
         }
-        
-        // Fill all channels
-        for (size_t ch = 0; ch < channelCount; ch++) {
-            buffer[i * channelCount + ch] = sample;
+
+        Request& request = samples->_requests[index];
+        int handle = (int)((request.generation << 8) | index);
+        RequestState result;
+
+        if (request.cancel || !running) {
+            result = REQUEST_CANCELLED;
+        } else {
+            request.state.store(SLOT_PLAYING, std::memory_order_release);
+            bool played = samples->runRequest(request);
+            result = played ? REQUEST_DONE : (request.cancel ? REQUEST_CANCELLED : REQUEST_FAILED);
         }
-    }
 
-    // Apply fade
-    size_t fadeLength = min(samplesNeeded / 20, (size_t)(_sampleRate * 0.01)); // 10ms fade
-    applyFade(buffer, totalSamples, fadeLength * channelCount, fadeLength * channelCount);
+        // Free the slot before the callback, so it can queue the next sound
+        CompletionCallback callback = request.callback;
+        void* userData = request.userData;
+        request.result = result;
+        request.state.store(SLOT_FREE, std::memory_order_release);
 
-    // Play the samples
-    bool result = false;
-    if (!_speaker->isActive()) {
-        _speaker->start();
+        if (callback) {
+            callback(handle, result, userData);
+        }
     }
-    
-    int samplesWritten = _speaker->writeSamples(buffer, totalSamples, 1000);
-    result = (samplesWritten > 0);
 
-    free(buffer);
-    _speaker->clear();
-    return result;
+    samples->_asyncTask = nullptr;
+    // Last access to the object: the destructor may free it once this is given
+    xSemaphoreGive(samples->_asyncStopped);
+    vTaskDelete(nullptr);
 }
 
 size_t AudioSamples::generateWaveform(int frequency, int duration, float amplitude,
@@ -323,68 +795,28 @@ size_t AudioSamples::generateWaveform(int frequency, int duration, float amplitu
     size_t samplesPerChannel = bufferSize / channelCount;
     size_t actualSamples = _min(samplesPerChannel, (_sampleRate * duration) / 1000);
 
-    float angularFreq = 2.0f * PI * frequency / _sampleRate;
-    int16_t maxAmplitude = (int16_t)(amplitude * 32767);
-
-    for (size_t i = 0; i < actualSamples; i++) {
-        float phase = angularFreq * i;
-        float sampleValue = generateWaveformSample(phase, waveform);
-        int16_t sample = (int16_t)(sampleValue * maxAmplitude);
-        
-        // Fill all channels with the same sample
-        for (size_t ch = 0; ch < channelCount; ch++) {
-            buffer[i * channelCount + ch] = sample;
-        }
-    }
+    Oscillator oscillator(_sampleRate, toOscillatorWaveform(waveform));
+    oscillator.setAmplitude(amplitude);
+    oscillator.setFrequency(frequency);
+    oscillator.render(buffer, actualSamples, channelCount);
 
     return actualSamples * channelCount;
 }
 
-float AudioSamples::generateWaveformSample(float phase, WaveformType waveform) {
-    float normalizedPhase = fmod(phase, 2.0f * PI);
-    
+Oscillator::Waveform AudioSamples::toOscillatorWaveform(WaveformType waveform) {
     switch (waveform) {
         case SINE:
-            return sin(normalizedPhase);
-            
+            return Oscillator::SINE;
         case SQUARE:
-            return (normalizedPhase < PI) ? 1.0f : -1.0f;
-            
+            return Oscillator::SQUARE;
         case TRIANGLE:
-            if (normalizedPhase < PI) {
-                return (2.0f * normalizedPhase / PI) - 1.0f;
-            } else {
-                return 3.0f - (2.0f * normalizedPhase / PI);
-            }
-            
+            return Oscillator::TRIANGLE;
         case SAWTOOTH:
-            return (normalizedPhase / PI) - 1.0f;
-            
+            return Oscillator::SAWTOOTH;
         case NOISE:
-            return ((float)random(65536) / 32768.0f) - 1.0f;
-            
+            return Oscillator::NOISE;
         default:
-            return sin(normalizedPhase);
-    }
-}
-
-void AudioSamples::applyFade(int16_t* buffer, size_t sampleCount, 
-                            size_t fadeInSamples, size_t fadeOutSamples) {
-    if (!buffer || sampleCount == 0) {
-        return;
-    }
-
-    // Apply fade in
-    for (size_t i = 0; i < min(fadeInSamples, sampleCount); i++) {
-        float fadeMultiplier = (float)i / fadeInSamples;
-        buffer[i] = (int16_t)(buffer[i] * fadeMultiplier);
-    }
-
-    // Apply fade out
-    size_t fadeOutStart = (sampleCount > fadeOutSamples) ? (sampleCount - fadeOutSamples) : 0;
-    for (size_t i = fadeOutStart; i < sampleCount; i++) {
-        float fadeMultiplier = (float)(sampleCount - i) / fadeOutSamples;
-        buffer[i] = (int16_t)(buffer[i] * fadeMultiplier);
+            return Oscillator::SINE;
     }
 }
 
@@ -415,35 +847,6 @@ bool AudioSamples::getDTMFFrequencies(char digit, int* lowFreq, int* highFreq) {
     }
 }
 
-size_t AudioSamples::generateDualTone(int freq1, int freq2, int duration, float amplitude,
-                                     int16_t* buffer, size_t bufferSize) {
-    if (!buffer || bufferSize == 0) {
-        return 0;
-    }
-
-    size_t channelCount = (_speaker->getChannelMode() == I2S_SLOT_MODE_STEREO) ? 2 : 1;
-    size_t samplesPerChannel = bufferSize / channelCount;
-    size_t actualSamples = _min(samplesPerChannel, (_sampleRate * duration) / 1000);
-
-    float angularFreq1 = 2.0f * PI * freq1 / _sampleRate;
-    float angularFreq2 = 2.0f * PI * freq2 / _sampleRate;
-    int16_t maxAmplitude = (int16_t)(amplitude * 32767 * 0.5f); // 0.5 to prevent clipping when mixing
-
-    for (size_t i = 0; i < actualSamples; i++) {
-        float sample1 = sin(angularFreq1 * i);
-        float sample2 = sin(angularFreq2 * i);
-        float mixedSample = sample1 + sample2;
-        int16_t sample = (int16_t)(mixedSample * maxAmplitude);
-        
-        // Fill all channels with the same sample
-        for (size_t ch = 0; ch < channelCount; ch++) {
-            buffer[i * channelCount + ch] = sample;
-        }
-    }
-
-    return actualSamples * channelCount;
-}
-
 void AudioSamples::setSampleRate(uint32_t sampleRate) {
     _sampleRate = sampleRate;
 }
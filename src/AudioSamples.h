@@ -1,7 +1,12 @@
 #pragma once
 
 #include <Arduino.h>
+#include <atomic>
 #include "I2SSpeaker.h"
+#include "Oscillator.h"
+#include "AudioSource.h"
+#include "AudioMixer.h"
+#include "SampleCache.h"
 
 /**
  * AudioSamples class for pre-generated audio effects and samples
@@ -9,6 +14,15 @@
  * This class provides a collection of pre-generated audio samples like beeps,
  * alarms, notification sounds, and other common audio effects that can be
  * played through an I2SSpeaker instance.
+ *
+ * With a mixer attached, sounds play as mixer voices on top of whatever
+ * else is playing (e.g. music), instead of writing to the speaker directly.
+ *
+ * With the sample cache enabled, each preset is rendered once into PSRAM
+ * and replayed from there, so repeated UI sounds cost no synthesis.
+ *
+ * The play*Async() variants queue the sound for an audio task and return
+ * immediately with a handle that can be polled or cancelled.
  */
 class AudioSamples {
 public:
@@ -30,7 +44,8 @@ public:
         SUCCESS,            // Success sound
         WARNING,            // Warning sound
         POWER_ON,           // Power on sound
-        POWER_OFF           // Power off sound
+        POWER_OFF,          // Power off sound
+        SAMPLE_TYPE_COUNT   // Number of sample types
     };
 
     /**
@@ -44,6 +59,33 @@ public:
         NOISE               // White noise
     };
 
+    /**
+     * State of an asynchronous request
+     */
+    enum RequestState {
+        REQUEST_UNKNOWN,    // Invalid handle, or finished long enough ago to be recycled
+        REQUEST_QUEUED,     // Waiting for the audio task
+        REQUEST_PLAYING,    // Being rendered
+        REQUEST_DONE,       // Played to the end
+        REQUEST_CANCELLED,  // Cancelled before or while playing
+        REQUEST_FAILED      // Could not be played
+    };
+
+    /**
+     * Called from the audio task when an asynchronous request ends
+     * 
+     * @param handle Handle returned when the request was queued
+     * @param state REQUEST_DONE, REQUEST_CANCELLED or REQUEST_FAILED
+     * @param userData User data passed when the request was queued
+     */
+    typedef void (*CompletionCallback)(int handle, RequestState state, void* userData);
+
+    static const size_t DEFAULT_CACHE_BUDGET = 512 * 1024;  // Sample cache budget in bytes
+
+    static const size_t MAX_REQUESTS = 16;                  // Asynchronous requests in flight
+    static const uint32_t ASYNC_TASK_STACK = 4096;
+    static const UBaseType_t ASYNC_TASK_PRIORITY = 5;
+
     /**
      * Constructor
      * 
@@ -90,6 +132,28 @@ public:
     bool playToneSequence(const int* frequencies, const int* durations, 
                          int count, float volume = 0.5f, int pauseBetween = 50);
 
+    /**
+     * Play a sequence of notes as one continuous stream
+     * 
+     * Gaps are rendered as silence, so timing is sample-accurate and the
+     * speaker is not drained between notes.
+     * 
+     * @param notes Notes to play (frequency, sweep target, duration, gap, waveform, gain)
+     * @param count Number of notes
+     * @param volume Volume level (0.0 to 1.0)
+     * @return true if successful, false otherwise
+     */
+    bool playSequence(const NoteEvent* notes, size_t count, float volume = 0.5f);
+
+    /**
+     * Get the note sequence of a pre-defined sample
+     * 
+     * @param sampleType Type of sample
+     * @param count Output for number of notes
+     * @return Notes of the preset, or nullptr for an unknown type
+     */
+    static const NoteEvent* getPreset(SampleType sampleType, size_t* count);
+
     /**
      * Play DTMF (telephone) tone
      * 
@@ -120,6 +184,183 @@ public:
      */
     bool playFrequencySweep(int startFreq, int endFreq, int duration, float volume = 0.5f);
 
+    /**
+     * Play a PCM clip recorded at any sample rate
+     * 
+     * The clip is resampled and channel-mixed to the speaker's format block
+     * by block, straight into the speaker's write slot.
+     * 
+     * @param samples Interleaved int16 samples
+     * @param frames Number of frames in the clip
+     * @param sampleRate Sample rate of the clip in Hz
+     * @param channels Channels in the clip (1 or 2)
+     * @param volume Volume level (0.0 to 1.0)
+     * @return true if successful, false otherwise
+     */
+    bool playPCM(const int16_t* samples, size_t frames, uint32_t sampleRate,
+                 size_t channels = 1, float volume = 0.5f);
+
+    /**
+     * Set resampler quality used by playPCM()
+     * 
+     * @param quality Resampler quality (default QUALITY_LOW)
+     */
+    void setResamplerQuality(Resampler::Quality quality);
+
+    /**
+     * Play through a mixer instead of writing to the speaker directly
+     * 
+     * Calls still block until the sound has finished.
+     * 
+     * @param mixer Running mixer that owns the speaker, nullptr to write directly again
+     * @param priority Voice priority; lower-priority voices are ducked while sounds play
+     */
+    void setMixer(AudioMixer* mixer, uint8_t priority = AudioMixer::PRIORITY_ALERT);
+
+    /**
+     * Enable the pre-rendered sample cache
+     * 
+     * Presets are rendered at full scale on first use (or by preloadSamples())
+     * and played back with the requested volume. Clips are keyed by sample
+     * type, sample rate and channel count; the least recently played clips
+     * are evicted when the budget is exceeded.
+     * 
+     * @param budgetBytes PSRAM budget for all cached clips
+     */
+    void enableCache(size_t budgetBytes = DEFAULT_CACHE_BUDGET);
+
+    /**
+     * Disable the sample cache and free all cached clips
+     */
+    void disableCache();
+
+    /**
+     * Render every preset into the cache now, e.g. at boot
+     * 
+     * @return Number of presets cached (already cached ones included)
+     */
+    size_t preloadSamples();
+
+    /**
+     * Get sample cache counters
+     * 
+     * @return Hits, misses, evictions and memory use
+     */
+    SampleCache::Stats getCacheStats() const;
+
+    /**
+     * Queue a pre-defined sample for the audio task
+     * 
+     * None of the *Async() calls ever block: when MAX_REQUESTS requests are
+     * already in flight the request is rejected with -1. The audio task is
+     * started on first use.
+     * 
+     * @param sampleType Type of sample to play
+     * @param volume Volume level (0.0 to 1.0)
+     * @param callback Optional completion callback, called from the audio task
+     * @param userData Passed to the callback
+     * @return Request handle, or -1 if the request was rejected
+     */
+    int playSampleAsync(SampleType sampleType, float volume = 0.5f,
+                        CompletionCallback callback = nullptr, void* userData = nullptr);
+
+    /**
+     * Queue a custom beep for the audio task
+     * 
+     * @param frequency Frequency in Hz
+     * @param duration Duration in milliseconds
+     * @param volume Volume level (0.0 to 1.0)
+     * @param waveform Waveform type
+     * @param callback Optional completion callback, called from the audio task
+     * @param userData Passed to the callback
+     * @return Request handle, or -1 if the request was rejected
+     */
+    int playBeepAsync(int frequency, int duration, float volume = 0.5f, WaveformType waveform = SINE,
+                      CompletionCallback callback = nullptr, void* userData = nullptr);
+
+    /**
+     * Queue a note sequence for the audio task
+     * 
+     * @param notes Notes to play (not copied, must stay valid until the request ends)
+     * @param count Number of notes
+     * @param volume Volume level (0.0 to 1.0)
+     * @param callback Optional completion callback, called from the audio task
+     * @param userData Passed to the callback
+     * @return Request handle, or -1 if the request was rejected
+     */
+    int playSequenceAsync(const NoteEvent* notes, size_t count, float volume = 0.5f,
+                          CompletionCallback callback = nullptr, void* userData = nullptr);
+
+    /**
+     * Queue a DTMF tone for the audio task
+     * 
+     * @param digit Digit to play (0-9, *, #, A-D)
+     * @param duration Duration in milliseconds
+     * @param volume Volume level (0.0 to 1.0)
+     * @param callback Optional completion callback, called from the audio task
+     * @param userData Passed to the callback
+     * @return Request handle, or -1 if the request was rejected
+     */
+    int playDTMFAsync(char digit, int duration = 200, float volume = 0.5f,
+                      CompletionCallback callback = nullptr, void* userData = nullptr);
+
+    /**
+     * Queue white noise for the audio task
+     * 
+     * @param duration Duration in milliseconds
+     * @param volume Volume level (0.0 to 1.0)
+     * @param callback Optional completion callback, called from the audio task
+     * @param userData Passed to the callback
+     * @return Request handle, or -1 if the request was rejected
+     */
+    int playWhiteNoiseAsync(int duration, float volume = 0.3f,
+                            CompletionCallback callback = nullptr, void* userData = nullptr);
+
+    /**
+     * Queue a frequency sweep for the audio task
+     * 
+     * @param startFreq Starting frequency in Hz
+     * @param endFreq Ending frequency in Hz
+     * @param duration Total duration in milliseconds
+     * @param volume Volume level (0.0 to 1.0)
+     * @param callback Optional completion callback, called from the audio task
+     * @param userData Passed to the callback
+     * @return Request handle, or -1 if the request was rejected
+     */
+    int playFrequencySweepAsync(int startFreq, int endFreq, int duration, float volume = 0.5f,
+                                CompletionCallback callback = nullptr, void* userData = nullptr);
+
+    /**
+     * Get the state of an asynchronous request
+     * 
+     * @param handle Request handle
+     * @return Request state
+     */
+    RequestState getRequestState(int handle) const;
+
+    /**
+     * Cancel an asynchronous request
+     * 
+     * A queued request is dropped; a playing one stops at its next block.
+     * The completion callback still fires with REQUEST_CANCELLED.
+     * 
+     * @param handle Request handle
+     * @return true if the request was still queued or playing
+     */
+    bool cancelRequest(int handle);
+
+    /**
+     * Cancel all queued and playing requests
+     */
+    void cancelAllRequests();
+
+    /**
+     * Get number of asynchronous requests queued or playing
+     * 
+     * @return Requests in flight
+     */
+    size_t getPendingRequestCount() const;
+
     /**
      * Generate a custom waveform sample
      * 
@@ -156,28 +397,163 @@ public:
     bool isReady() const;
 
 private:
+    static const size_t RENDER_BLOCK_FRAMES = 256;  // Frames rendered per block when streaming
+    static const uint32_t VOICE_POLL_MS = 5;         // Completion poll interval with a mixer
+
     I2SSpeaker* _speaker;
     uint32_t _sampleRate;
-    
+    PcmSource _pcmSource;
+    Resampler::Quality _resamplerQuality;
+    AudioMixer* _mixer;
+    uint8_t _mixerPriority;
+    SampleCache _cache;
+    AudioSink* _capture;                             // Set while rendering a preset into the cache
+    SemaphoreHandle_t _renderLock;                   // Serializes blocking calls and the audio task
+
+    enum RequestKind : uint8_t {
+        KIND_SAMPLE,
+        KIND_BEEP,
+        KIND_SEQUENCE,
+        KIND_DTMF,
+        KIND_NOISE,
+        KIND_SWEEP
+    };
+
+    enum SlotState : uint8_t {
+        SLOT_FREE,
+        SLOT_CLAIMED,       // Being filled by the caller
+        SLOT_QUEUED,
+        SLOT_PLAYING
+    };
+
+    struct Request {
+        std::atomic<uint8_t> state;
+        uint8_t generation;
+        volatile bool cancel;
+        volatile uint8_t result;        // RequestState once the slot is free again
+        RequestKind kind;
+        SampleType sampleType;
+        WaveformType waveform;
+        char digit;
+        int frequency;
+        int endFrequency;
+        int duration;
+        const NoteEvent* notes;
+        size_t count;
+        float volume;
+        CompletionCallback callback;
+        void* userData;
+
+        Request() : state(SLOT_FREE), generation(0), cancel(false), result(REQUEST_UNKNOWN) {}
+    };
+
+    Request _requests[MAX_REQUESTS];
+    QueueHandle_t volatile _requestQueue;            // Slot indices in playing order
+    TaskHandle_t volatile _asyncTask;
+    SemaphoreHandle_t _asyncStopped;                 // Given by the audio task right before it deletes itself
+    std::atomic<bool> _asyncStarted;
+    volatile bool _asyncRunning;
+    const volatile bool* _cancel;                    // Cancel flag of the request being rendered
+
+    /**
+     * Claim a free request slot
+     * 
+     * @return Slot, or nullptr if all are in flight
+     */
+    Request* claimRequest(RequestKind kind, float volume, CompletionCallback callback, void* userData);
+
     /**
-     * Generate a single waveform sample
+     * Queue a filled request slot, starting the audio task if needed
+     * 
+     * @return Request handle, or -1 if the request was rejected
+     */
+    int submitRequest(Request* request);
+
+    /**
+     * Resolve a handle to its slot if the handle is still current
+     */
+    Request* lookupRequest(int handle) const;
+
+    /**
+     * Render one request on the audio task
+     * 
+     * @return true if it played to the end
+     */
+    bool runRequest(const Request& request);
+
+    /**
+     * Start the audio task
+     * 
+     * @return true if the task is running
+     */
+    bool startAsyncTask();
+
+    /**
+     * Audio task entry point
+     */
+    static void asyncTask(void* param);
+
+    /**
+     * Get a preset from the cache, rendering it on a miss
+     * 
+     * @param sampleType Type of sample
+     * @param frames Output for clip length in frames
+     * @return Clip samples, or nullptr if it could not be cached
+     */
+    const int16_t* cachedSample(SampleType sampleType, size_t* frames);
+
+    /**
+     * Render a preset at full scale and add it to the cache
+     * 
+     * @param sampleType Type of sample
+     * @return true if the clip was cached
+     */
+    bool renderToCache(SampleType sampleType);
+
+    /**
+     * Map a waveform type to the oscillator waveform
      * 
-     * @param phase Current phase (0 to 2*PI)
      * @param waveform Waveform type
-     * @return Sample value (-1.0 to 1.0)
+     * @return Oscillator waveform
+     */
+    static Oscillator::Waveform toOscillatorWaveform(WaveformType waveform);
+
+    /**
+     * Render oscillators block by block and stream them to the speaker
+     * 
+     * The first oscillator overwrites each block, the others are mixed in.
+     * 
+     * @param oscillators Oscillators to render
+     * @param oscillatorCount Number of oscillators
+     * @param frames Clip length in frames
+     * @param fadeFrames Fade in/out length in frames
+     * @return true if every block was written
+     */
+    bool streamOscillators(Oscillator* oscillators, size_t oscillatorCount,
+                           size_t frames, size_t fadeFrames);
+
+    /**
+     * Play a source to completion, through the mixer or straight to the speaker
+     * 
+     * While capturing, the source is recorded into the capture sink instead.
+     * 
+     * @param source Source to play
+     * @param volume Gain applied to the source (0.0 to 1.0)
+     * @return true if the source played to the end
      */
-    float generateWaveformSample(float phase, WaveformType waveform);
+    bool playSource(AudioSource* source, float volume);
 
     /**
-     * Apply fade in/out to prevent audio clicks
+     * Render a source block by block into a sink's write slots
      * 
-     * @param buffer Buffer containing samples
-     * @param sampleCount Number of samples
-     * @param fadeInSamples Number of samples for fade in
-     * @param fadeOutSamples Number of samples for fade out
+     * @param sink Sink to write to
+     * @param source Source to render
+     * @param volume Gain applied to the source (0.0 to 1.0)
+     * @param cancel Stops rendering when set (may be nullptr)
+     * @return true if every block was committed
      */
-    void applyFade(int16_t* buffer, size_t sampleCount, 
-                   size_t fadeInSamples, size_t fadeOutSamples);
+    static bool renderTo(AudioSink* sink, AudioSource* source, float volume,
+                         const volatile bool* cancel = nullptr);
 
     /**
      * Generate DTMF tone pair
@@ -188,18 +564,4 @@ private:
      * @return true if valid digit, false otherwise
      */
     bool getDTMFFrequencies(char digit, int* lowFreq, int* highFreq);
-
-    /**
-     * Mix two frequencies together
-     * 
-     * @param freq1 First frequency
-     * @param freq2 Second frequency
-     * @param duration Duration in milliseconds
-     * @param amplitude Amplitude (0.0 to 1.0)
-     * @param buffer Output buffer
-     * @param bufferSize Buffer size in samples
-     * @return Number of samples generated
-     */
-    size_t generateDualTone(int freq1, int freq2, int duration, float amplitude,
-                           int16_t* buffer, size_t bufferSize);
 };
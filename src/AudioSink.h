@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * AudioSink interface for acquire/commit style PCM output
+ *
+ * Producers ask the sink for its next free write slot, render PCM directly
+ * into it and then commit the number of bytes they actually produced. This
+ * removes the staging buffer every producer would otherwise need.
+ *
+ * Slots always carry interleaved int16 PCM. Sinks with a wider native output
+ * format convert the committed samples in place.
+ */
+class AudioSink {
+public:
+    virtual ~AudioSink() {}
+
+    /**
+     * Acquire the next free write slot
+     *
+     * Only one slot can be held at a time; it must be released with
+     * commitBuffer() before acquiring another one.
+     *
+     * @param capacity Output for slot size in bytes of int16 PCM
+     * @param timeoutMs Timeout in milliseconds to wait for a free slot
+     * @return Pointer to the slot, or nullptr if none is available
+     */
+    virtual void* acquireBuffer(size_t* capacity, uint32_t timeoutMs = 100) = 0;
+
+    /**
+     * Commit PCM rendered into the slot returned by acquireBuffer()
+     *
+     * The slot is released even if the commit fails.
+     *
+     * @param bytes Number of bytes rendered (0 releases the slot unused)
+     * @param timeoutMs Timeout in milliseconds for the slot to be queued
+     * @return true if all bytes were queued for output
+     */
+    virtual bool commitBuffer(size_t bytes, uint32_t timeoutMs = 100) = 0;
+
+    /**
+     * Get output sample rate
+     *
+     * @return Sample rate in Hz
+     */
+    virtual uint32_t getSampleRate() const = 0;
+
+    /**
+     * Get number of interleaved output channels
+     *
+     * @return Number of channels (1 or 2)
+     */
+    virtual size_t getChannelCount() const = 0;
+};
@@ -0,0 +1,244 @@
+#include "AudioSource.h"
+#include <cstring>
+
+RingAudioSource::RingAudioSource()
+    : _ring(nullptr), _channels(1), _prebufferFrames(0), _started(false), _ended(false) {
+}
+
+void RingAudioSource::attach(PcmRingBuffer* ring, size_t channels, size_t prebufferFrames) {
+    _ring = ring;
+    _channels = (channels > 0) ? channels : 1;
+    _prebufferFrames = prebufferFrames;
+    _started = false;
+    _ended.store(false, std::memory_order_release);
+}
+
+void RingAudioSource::markEnd() {
+    _ended.store(true, std::memory_order_release);
+}
+
+size_t RingAudioSource::read(int16_t* buffer, size_t frames) {
+    if (!_ring || !buffer) {
+        return 0;
+    }
+
+    size_t availableFrames = _ring->available() / _channels;
+    if (!_started) {
+        if (availableFrames < _prebufferFrames && !_ended.load(std::memory_order_acquire)) {
+            return 0;
+        }
+        _started = true;
+    }
+
+    size_t count = (frames < availableFrames) ? frames : availableFrames;
+    return _ring->read(buffer, count * _channels) / _channels;
+}
+
+bool RingAudioSource::isFinished() const {
+    return !_ring || (_ended.load(std::memory_order_acquire) && _ring->available() < _channels);
+}
+
+ToneSource::ToneSource(Oscillator* oscillators, size_t oscillatorCount, size_t frames,
+                       size_t fadeFrames, size_t channels)
+    : _oscillators(oscillators), _oscillatorCount(oscillators ? oscillatorCount : 0), _frames(frames),
+      _fadeFrames(fadeFrames), _channels(channels), _position(0) {
+}
+
+size_t ToneSource::read(int16_t* buffer, size_t frames) {
+    if (!buffer || _oscillatorCount == 0) {
+        return 0;
+    }
+
+    size_t count = _frames - _position;
+    if (frames < count) {
+        count = frames;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    _oscillators[0].render(buffer, count, _channels);
+    for (size_t i = 1; i < _oscillatorCount; i++) {
+        _oscillators[i].renderAdd(buffer, count, _channels);
+    }
+    applyFade(buffer, count, _channels, _position, _frames, _fadeFrames, _fadeFrames);
+
+    _position += count;
+    return count;
+}
+
+bool ToneSource::isFinished() const {
+    return _oscillatorCount == 0 || _position >= _frames;
+}
+
+void ToneSource::applyFade(int16_t* buffer, size_t frames, size_t channels,
+                           size_t startFrame, size_t totalFrames,
+                           size_t fadeInFrames, size_t fadeOutFrames) {
+    if (!buffer || frames == 0) {
+        return;
+    }
+
+    size_t fadeOutStart = (totalFrames > fadeOutFrames) ? (totalFrames - fadeOutFrames) : 0;
+
+    for (size_t i = 0; i < frames; i++) {
+        size_t position = startFrame + i;
+        float fadeMultiplier;
+
+        if (position < fadeInFrames) {
+            fadeMultiplier = (float)position / fadeInFrames;
+        } else if (fadeOutFrames > 0 && position >= fadeOutStart) {
+            fadeMultiplier = (float)(totalFrames - position) / fadeOutFrames;
+        } else {
+            continue;
+        }
+
+        for (size_t ch = 0; ch < channels; ch++) {
+            int16_t* sample = &buffer[i * channels + ch];
+            *sample = (int16_t)(*sample * fadeMultiplier);
+        }
+    }
+}
+
+SequenceSource::SequenceSource()
+    : _notes(nullptr), _count(0), _index(0), _sampleRate(16000), _channels(1),
+      _toneFrames(0), _noteFrames(0), _fadeFrames(0), _position(0) {
+}
+
+SequenceSource::SequenceSource(const NoteEvent* notes, size_t count, uint32_t sampleRate, size_t channels)
+    : SequenceSource() {
+    open(notes, count, sampleRate, channels);
+}
+
+void SequenceSource::open(const NoteEvent* notes, size_t count, uint32_t sampleRate, size_t channels) {
+    _notes = notes;
+    _count = notes ? count : 0;
+    _index = 0;
+    _sampleRate = sampleRate;
+    _channels = (channels > 0) ? channels : 1;
+    _oscillator.setSampleRate(sampleRate);
+    startNote();
+}
+
+void SequenceSource::startNote() {
+    for (; _index < _count; _index++) {
+        const NoteEvent& note = _notes[_index];
+        _toneFrames = ((size_t)_sampleRate * note.durationMs) / 1000;
+        _noteFrames = _toneFrames + ((size_t)_sampleRate * note.gapMs) / 1000;
+        _position = 0;
+        if (_noteFrames > 0) {
+            break;
+        }
+    }
+    if (_index >= _count) {
+        return;
+    }
+
+    const NoteEvent& note = _notes[_index];
+    size_t maxFade = ((size_t)_sampleRate * FADE_MS) / 1000;
+    _fadeFrames = (_toneFrames / 20 < maxFade) ? _toneFrames / 20 : maxFade;
+
+    _oscillator.setWaveform(note.waveform);
+    _oscillator.setAmplitude(note.gain);
+    _oscillator.setFrequency(note.frequency);
+    _oscillator.resetPhase();
+    if (note.endFrequency > 0) {
+        _oscillator.sweepTo(note.endFrequency, _toneFrames);
+    }
+}
+
+size_t SequenceSource::read(int16_t* buffer, size_t frames) {
+    if (!buffer) {
+        return 0;
+    }
+
+    size_t produced = 0;
+    while (produced < frames && _index < _count) {
+        int16_t* out = buffer + produced * _channels;
+        size_t count;
+
+        if (_position < _toneFrames) {
+            count = _toneFrames - _position;
+            if (frames - produced < count) {
+                count = frames - produced;
+            }
+            _oscillator.render(out, count, _channels);
+            ToneSource::applyFade(out, count, _channels, _position, _toneFrames, _fadeFrames, _fadeFrames);
+        } else {
+            count = _noteFrames - _position;
+            if (frames - produced < count) {
+                count = frames - produced;
+            }
+            memset(out, 0, count * _channels * sizeof(int16_t));
+        }
+
+        produced += count;
+        _position += count;
+        if (_position >= _noteFrames) {
+            _index++;
+            startNote();
+        }
+    }
+
+    return produced;
+}
+
+bool SequenceSource::isFinished() const {
+    return _index >= _count;
+}
+
+// Silent input fed to the converter after a clip
+static const size_t FLUSH_BLOCK_FRAMES = 32;
+static const int16_t FLUSH_SILENCE[FLUSH_BLOCK_FRAMES * FormatConverter::MAX_CHANNELS] = {0};
+
+PcmSource::PcmSource() : _samples(nullptr), _framesLeft(0), _flushLeft(0), _channels(1) {
+}
+
+bool PcmSource::open(const int16_t* samples, size_t frames, uint32_t sampleRate, size_t channels,
+                     uint32_t outRate, size_t outChannels, Resampler::Quality quality) {
+    _samples = nullptr;
+    _framesLeft = 0;
+    _flushLeft = 0;
+
+    if (!samples || !_converter.configure(sampleRate, channels, outRate, outChannels, quality)) {
+        return false;
+    }
+
+    _samples = samples;
+    _framesLeft = frames;
+    _flushLeft = _converter.getFlushFrames();
+    _channels = channels;
+    return true;
+}
+
+size_t PcmSource::read(int16_t* buffer, size_t frames) {
+    if (!buffer || isFinished()) {
+        return 0;
+    }
+
+    size_t produced = 0;
+    if (_framesLeft > 0) {
+        size_t consumed = 0;
+        produced = _converter.process(_samples, _framesLeft, buffer, frames, &consumed);
+        _samples += consumed * _channels;
+        _framesLeft -= consumed;
+    }
+
+    // After the clip, feed silence until the resampler history has drained,
+    // so the filter delay does not cut off the end of the clip
+    size_t outChannels = _converter.getOutputChannels();
+    while (_framesLeft == 0 && _flushLeft > 0 && produced < frames) {
+        size_t block = (_flushLeft < FLUSH_BLOCK_FRAMES) ? _flushLeft : FLUSH_BLOCK_FRAMES;
+        size_t consumed = 0;
+        produced += _converter.process(FLUSH_SILENCE, block, buffer + produced * outChannels,
+                                       frames - produced, &consumed);
+        _flushLeft -= consumed;
+        if (consumed < block) {
+            break;  // Output full
+        }
+    }
+    return produced;
+}
+
+bool PcmSource::isFinished() const {
+    return _framesLeft == 0 && _flushLeft == 0;
+}
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "SpscRingBuffer.h"
+#include "Oscillator.h"
+#include "FormatConverter.h"
+
+/**
+ * AudioSource interface for pull-style PCM producers
+ *
+ * A source renders interleaved int16 frames on demand, already in the
+ * output format (sample rate and channel count) of whatever pulls from it,
+ * typically an AudioMixer voice. Returning fewer frames than requested
+ * while isFinished() is false means the source is starved for now; the
+ * puller fills the gap with silence and asks again next block.
+ */
+class AudioSource {
+public:
+    virtual ~AudioSource() {}
+
+    /**
+     * Render up to frames frames
+     *
+     * @param buffer Output for interleaved int16 frames
+     * @param frames Number of frames requested
+     * @return Number of frames rendered
+     */
+    virtual size_t read(int16_t* buffer, size_t frames) = 0;
+
+    /**
+     * Check whether the source has no more frames to give
+     *
+     * @return true once the last frame has been read
+     */
+    virtual bool isFinished() const = 0;
+};
+
+/**
+ * Source draining a PCM ring filled by another task (e.g. an MP3 decoder)
+ *
+ * Holds back output until a prebuffer threshold is reached so decode
+ * jitter at stream start does not cause gaps. The producer calls
+ * markEnd() after its last write.
+ */
+class RingAudioSource : public AudioSource {
+public:
+    RingAudioSource();
+
+    /**
+     * Attach a ring and reset state
+     *
+     * @param ring Ring holding interleaved frames
+     * @param channels Channels per frame
+     * @param prebufferFrames Frames buffered before the first read succeeds
+     */
+    void attach(PcmRingBuffer* ring, size_t channels, size_t prebufferFrames = 0);
+
+    /**
+     * Signal that the producer will write no more frames
+     */
+    void markEnd();
+
+    size_t read(int16_t* buffer, size_t frames) override;
+    bool isFinished() const override;
+
+private:
+    PcmRingBuffer* _ring;
+    size_t _channels;
+    size_t _prebufferFrames;
+    bool _started;
+    std::atomic<bool> _ended;
+};
+
+/**
+ * Source rendering one or more oscillators summed, with fade in/out
+ *
+ * Renders a fixed number of frames; the first oscillator writes each block,
+ * the others are mixed in. The fades avoid clicks at tone boundaries.
+ */
+class ToneSource : public AudioSource {
+public:
+    /**
+     * @param oscillators Oscillators to render (not copied, must outlive the source)
+     * @param oscillatorCount Number of oscillators
+     * @param frames Tone length in frames
+     * @param fadeFrames Fade in/out length in frames
+     * @param channels Output channels
+     */
+    ToneSource(Oscillator* oscillators, size_t oscillatorCount, size_t frames,
+               size_t fadeFrames, size_t channels);
+
+    size_t read(int16_t* buffer, size_t frames) override;
+    bool isFinished() const override;
+
+    /**
+     * Apply fade in/out to one block of a longer clip
+     *
+     * @param buffer Block containing interleaved samples
+     * @param frames Number of frames in the block
+     * @param channels Number of interleaved channels
+     * @param startFrame Position of the block's first frame within the clip
+     * @param totalFrames Length of the whole clip in frames
+     * @param fadeInFrames Number of frames for fade in
+     * @param fadeOutFrames Number of frames for fade out
+     */
+    static void applyFade(int16_t* buffer, size_t frames, size_t channels,
+                          size_t startFrame, size_t totalFrames,
+                          size_t fadeInFrames, size_t fadeOutFrames);
+
+private:
+    Oscillator* _oscillators;
+    size_t _oscillatorCount;
+    size_t _frames;
+    size_t _fadeFrames;
+    size_t _channels;
+    size_t _position;
+};
+
+/**
+ * One note of a sequence: a tone (or sweep) followed by silence
+ *
+ * Literal type, so sequences can live in constexpr tables in flash.
+ */
+struct NoteEvent {
+    uint16_t frequency;         // Start frequency in Hz
+    uint16_t endFrequency;      // Sweep target in Hz, 0 for a steady tone
+    uint16_t durationMs;        // Tone length
+    uint16_t gapMs;             // Silence after the tone
+    Oscillator::Waveform waveform;
+    float gain;                 // Note amplitude (0.0 to 1.0)
+};
+
+/**
+ * Source rendering a sequence of notes as one continuous stream
+ *
+ * Notes and the gaps between them are rendered sample-accurately into the
+ * same stream, so a sequence plays without pauses on the caller's side and
+ * without draining the output between notes. Each note fades in and out
+ * over up to 5 ms to avoid clicks.
+ */
+class SequenceSource : public AudioSource {
+public:
+    static const uint32_t FADE_MS = 5;
+
+    SequenceSource();
+
+    /**
+     * @param notes Notes to play (not copied, must outlive the source)
+     * @param count Number of notes
+     * @param sampleRate Output sample rate in Hz
+     * @param channels Output channels
+     */
+    SequenceSource(const NoteEvent* notes, size_t count, uint32_t sampleRate, size_t channels);
+
+    /**
+     * Start a new sequence
+     *
+     * @param notes Notes to play (not copied, must outlive the source)
+     * @param count Number of notes
+     * @param sampleRate Output sample rate in Hz
+     * @param channels Output channels
+     */
+    void open(const NoteEvent* notes, size_t count, uint32_t sampleRate, size_t channels);
+
+    size_t read(int16_t* buffer, size_t frames) override;
+    bool isFinished() const override;
+
+private:
+    const NoteEvent* _notes;
+    size_t _count;
+    size_t _index;          // Current note
+    uint32_t _sampleRate;
+    size_t _channels;
+    Oscillator _oscillator;
+    size_t _toneFrames;     // Tone length of the current note
+    size_t _noteFrames;     // Tone plus gap of the current note
+    size_t _fadeFrames;
+    size_t _position;       // Position within the current note
+
+    /**
+     * Set up the oscillator for the note at _index, skipping empty notes
+     */
+    void startNote();
+};
+
+/**
+ * Source playing a PCM clip from memory, converted to the output format
+ */
+class PcmSource : public AudioSource {
+public:
+    PcmSource();
+
+    /**
+     * Set up the clip and the conversion to the output format
+     *
+     * @param samples Interleaved int16 samples (not copied)
+     * @param frames Number of frames in the clip
+     * @param sampleRate Sample rate of the clip in Hz
+     * @param channels Channels in the clip (1 or 2)
+     * @param outRate Output sample rate in Hz
+     * @param outChannels Output channels (1 or 2)
+     * @param quality Resampler quality when the rates differ
+     * @return true if the formats are supported
+     */
+    bool open(const int16_t* samples, size_t frames, uint32_t sampleRate, size_t channels,
+              uint32_t outRate, size_t outChannels,
+              Resampler::Quality quality = Resampler::QUALITY_LOW);
+
+    size_t read(int16_t* buffer, size_t frames) override;
+    bool isFinished() const override;
+
+private:
+    const int16_t* _samples;
+    size_t _framesLeft;
+    size_t _flushLeft;          // Silent frames still to feed after the clip
+    size_t _channels;
+    FormatConverter _converter;
+};
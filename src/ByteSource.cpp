@@ -0,0 +1,122 @@
+#include "ByteSource.h"
+#include <string.h>
+
+MemoryByteSource::MemoryByteSource() : _data(nullptr), _size(0), _position(0) {
+}
+
+MemoryByteSource::MemoryByteSource(const uint8_t* data, size_t size)
+    : _data(data), _size(data ? size : 0), _position(0) {
+}
+
+void MemoryByteSource::open(const uint8_t* data, size_t size) {
+    _data = data;
+    _size = data ? size : 0;
+    _position = 0;
+}
+
+size_t MemoryByteSource::read(uint8_t* buffer, size_t length) {
+    if (!buffer || !_data) {
+        return 0;
+    }
+
+    size_t count = _size - _position;
+    if (length < count) {
+        count = length;
+    }
+    memcpy(buffer, _data + _position, count);
+    _position += count;
+    return count;
+}
+
+bool MemoryByteSource::seek(size_t position) {
+    if (position > _size) {
+        return false;
+    }
+    _position = position;
+    return true;
+}
+
+RingByteSource::RingByteSource() : _ring(nullptr), _totalSize(0), _position(0), _ended(false) {
+}
+
+void RingByteSource::attach(ByteRingBuffer* ring, size_t totalSize) {
+    _ring = ring;
+    _totalSize = totalSize;
+    _position = 0;
+    _ended.store(false, std::memory_order_release);
+}
+
+void RingByteSource::markEnd() {
+    _ended.store(true, std::memory_order_release);
+}
+
+size_t RingByteSource::read(uint8_t* buffer, size_t length) {
+    if (!_ring || !buffer) {
+        return 0;
+    }
+
+    size_t count = _ring->read(buffer, length);
+    _position += count;
+    return count;
+}
+
+size_t RingByteSource::available() const {
+    return _ring ? _ring->available() : 0;
+}
+
+bool RingByteSource::isEnd() const {
+    return !_ring || (_ended.load(std::memory_order_acquire) && _ring->available() == 0);
+}
+
+StdioByteSource::StdioByteSource() : _file(nullptr), _size(0), _position(0) {
+}
+
+StdioByteSource::~StdioByteSource() {
+    close();
+}
+
+bool StdioByteSource::open(const char* path) {
+    close();
+
+    if (!path) {
+        return false;
+    }
+
+    _file = fopen(path, "rb");
+    if (!_file) {
+        return false;
+    }
+
+    fseek(_file, 0, SEEK_END);
+    long end = ftell(_file);
+    fseek(_file, 0, SEEK_SET);
+    _size = (end > 0) ? (size_t)end : 0;
+    return true;
+}
+
+void StdioByteSource::close() {
+    if (_file) {
+        fclose(_file);
+        _file = nullptr;
+    }
+    _size = 0;
+    _position = 0;
+}
+
+size_t StdioByteSource::read(uint8_t* buffer, size_t length) {
+    if (!_file || !buffer) {
+        return 0;
+    }
+
+    size_t count = fread(buffer, 1, length, _file);
+    _position += count;
+    return count;
+}
+
+bool StdioByteSource::seek(size_t position) {
+    if (!_file || position > _size || fseek(_file, (long)position, SEEK_SET) != 0) {
+        return false;
+    }
+    _position = position;
+    return true;
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include "SpscRingBuffer.h"
+
+/**
+ * ByteSource interface for compressed stream input
+ *
+ * Decoders pull encoded bytes through this interface instead of opening
+ * files themselves, so the same decoder can stream from any filesystem, a
+ * memory buffer (PROGMEM, PSRAM) or a ring fed by another task (network).
+ *
+ * A read() that returns 0 while isEnd() is false means no data is
+ * available yet; the caller should retry later.
+ */
+class ByteSource {
+public:
+    virtual ~ByteSource() {}
+
+    /**
+     * Read up to length bytes
+     *
+     * @param buffer Destination
+     * @param length Maximum bytes to read
+     * @return Bytes read, 0 at end of stream or when no data is available yet
+     */
+    virtual size_t read(uint8_t* buffer, size_t length) = 0;
+
+    /**
+     * Move the read position
+     *
+     * @param position Absolute byte offset from the start of the stream
+     * @return false if the source is not seekable or the offset is invalid
+     */
+    virtual bool seek(size_t position) { (void)position; return false; }
+
+    /**
+     * Get total stream size
+     *
+     * @return Size in bytes, 0 if unknown
+     */
+    virtual size_t size() const { return 0; }
+
+    /**
+     * Get current read position
+     *
+     * @return Byte offset from the start of the stream
+     */
+    virtual size_t position() const = 0;
+
+    /**
+     * Get number of bytes that can be read without waiting
+     *
+     * @return Bytes available now
+     */
+    virtual size_t available() const = 0;
+
+    /**
+     * Check whether the stream has ended
+     *
+     * @return true once every byte has been read and no more will arrive
+     */
+    virtual bool isEnd() const = 0;
+
+    /**
+     * Check whether seek() is supported
+     *
+     * @return true if the source can seek
+     */
+    virtual bool isSeekable() const { return false; }
+};
+
+/**
+ * Source reading from a buffer in memory (RAM, PSRAM or flash-mapped data)
+ */
+class MemoryByteSource : public ByteSource {
+public:
+    MemoryByteSource();
+
+    /**
+     * @param data Encoded bytes (not copied, must outlive the source)
+     * @param size Number of bytes
+     */
+    MemoryByteSource(const uint8_t* data, size_t size);
+
+    /**
+     * Point the source at a new buffer and rewind
+     *
+     * @param data Encoded bytes (not copied, must outlive the source)
+     * @param size Number of bytes
+     */
+    void open(const uint8_t* data, size_t size);
+
+    size_t read(uint8_t* buffer, size_t length) override;
+    bool seek(size_t position) override;
+    size_t size() const override { return _size; }
+    size_t position() const override { return _position; }
+    size_t available() const override { return _size - _position; }
+    bool isEnd() const override { return _position >= _size; }
+    bool isSeekable() const override { return true; }
+
+private:
+    const uint8_t* _data;
+    size_t _size;
+    size_t _position;
+};
+
+/**
+ * Source draining a byte ring filled by another task (e.g. an HTTP client)
+ *
+ * The producer writes into the ring and calls markEnd() after its last
+ * write. Not seekable.
+ */
+class RingByteSource : public ByteSource {
+public:
+    RingByteSource();
+
+    /**
+     * Start reading from a ring
+     *
+     * @param ring Ring filled by the producer
+     * @param totalSize Expected stream size (e.g. Content-Length), 0 if unknown
+     */
+    void attach(ByteRingBuffer* ring, size_t totalSize = 0);
+
+    /**
+     * Called by the producer after its last write
+     */
+    void markEnd();
+
+    size_t read(uint8_t* buffer, size_t length) override;
+    size_t size() const override { return _totalSize; }
+    size_t position() const override { return _position; }
+    size_t available() const override;
+    bool isEnd() const override;
+
+private:
+    ByteRingBuffer* _ring;
+    size_t _totalSize;
+    size_t _position;
+    std::atomic<bool> _ended;
+};
+
+/**
+ * Source reading a file through C stdio
+ *
+ * Works with the ESP-IDF VFS (SPIFFS, FAT, LittleFS mount points) as well
+ * as with plain files on a Linux host.
+ */
+class StdioByteSource : public ByteSource {
+public:
+    StdioByteSource();
+    ~StdioByteSource();
+
+    /**
+     * Open a file, closing any previous one
+     *
+     * @param path File path
+     * @return true if the file was opened
+     */
+    bool open(const char* path);
+
+    /**
+     * Close the file
+     */
+    void close();
+
+    bool isOpen() const { return _file != nullptr; }
+
+    size_t read(uint8_t* buffer, size_t length) override;
+    bool seek(size_t position) override;
+    size_t size() const override { return _size; }
+    size_t position() const override { return _position; }
+    size_t available() const override { return _size - _position; }
+    bool isEnd() const override { return !_file || _position >= _size; }
+    bool isSeekable() const override { return true; }
+
+private:
+    FILE* _file;
+    size_t _size;
+    size_t _position;
+};
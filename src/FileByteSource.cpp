@@ -0,0 +1,52 @@
+#include "FileByteSource.h"
+
+FileByteSource::FileByteSource() : _size(0), _position(0) {
+}
+
+FileByteSource::~FileByteSource() {
+    close();
+}
+
+bool FileByteSource::open(fs::FS& fs, const String& path) {
+    return open(fs.open(path, "r"));
+}
+
+bool FileByteSource::open(File file) {
+    close();
+
+    if (!file) {
+        return false;
+    }
+
+    _file = file;
+    _size = _file.size();
+    _position = 0;
+    return true;
+}
+
+void FileByteSource::close() {
+    if (_file) {
+        _file.close();
+    }
+    _file = File();
+    _size = 0;
+    _position = 0;
+}
+
+size_t FileByteSource::read(uint8_t* buffer, size_t length) {
+    if (!_file || !buffer) {
+        return 0;
+    }
+
+    size_t count = _file.read(buffer, length);
+    _position += count;
+    return count;
+}
+
+bool FileByteSource::seek(size_t position) {
+    if (!_file || position > _size || !_file.seek(position)) {
+        return false;
+    }
+    _position = position;
+    return true;
+}
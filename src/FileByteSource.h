@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include "ByteSource.h"
+
+/**
+ * Source reading a file through the Arduino FS API
+ *
+ * Works with any fs::FS implementation: SPIFFS, LittleFS, SD, SD_MMC or FFat.
+ */
+class FileByteSource : public ByteSource {
+public:
+    FileByteSource();
+    ~FileByteSource();
+
+    /**
+     * Open a file, closing any previous one
+     *
+     * @param fs Filesystem holding the file
+     * @param path File path
+     * @return true if the file was opened
+     */
+    bool open(fs::FS& fs, const String& path);
+
+    /**
+     * Take over an already opened file, closing any previous one
+     *
+     * @param file Open file
+     * @return true if the file is valid
+     */
+    bool open(File file);
+
+    /**
+     * Close the file
+     */
+    void close();
+
+    bool isOpen() const { return _file; }
+
+    size_t read(uint8_t* buffer, size_t length) override;
+    bool seek(size_t position) override;
+    size_t size() const override { return _size; }
+    size_t position() const override { return _position; }
+    size_t available() const override { return _size - _position; }
+    bool isEnd() const override { return !_file || _position >= _size; }
+    bool isSeekable() const override { return true; }
+
+private:
+    mutable File _file;
+    size_t _size;
+    size_t _position;
+};
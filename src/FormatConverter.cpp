@@ -0,0 +1,99 @@
+#include "FormatConverter.h"
+#include <string.h>
+
+FormatConverter::FormatConverter()
+    : _inRate(0), _outRate(0), _inChannels(0), _outChannels(0) {
+}
+
+bool FormatConverter::configure(uint32_t inRate, size_t inChannels, uint32_t outRate, size_t outChannels,
+                                Resampler::Quality quality) {
+    if (inRate == 0 || outRate == 0 ||
+        inChannels == 0 || inChannels > MAX_CHANNELS ||
+        outChannels == 0 || outChannels > MAX_CHANNELS) {
+        return false;
+    }
+
+    // Resample on the narrower side of the channel change
+    size_t resampleChannels = (inChannels < outChannels) ? inChannels : outChannels;
+    if (!_resampler.configure(inRate, outRate, resampleChannels, quality)) {
+        _inChannels = 0;
+        return false;
+    }
+
+    _inRate = inRate;
+    _outRate = outRate;
+    _inChannels = inChannels;
+    _outChannels = outChannels;
+    return true;
+}
+
+void FormatConverter::reset() {
+    _resampler.reset();
+}
+
+bool FormatConverter::isPassthrough() const {
+    return _inRate == _outRate && _inChannels == _outChannels;
+}
+
+bool FormatConverter::matchesSource(uint32_t inRate, size_t inChannels) const {
+    return _inRate == inRate && _inChannels == inChannels;
+}
+
+void FormatConverter::downmix(const int16_t* in, int16_t* out, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        out[i] = (int16_t)(((int32_t)in[2 * i] + in[2 * i + 1]) >> 1);
+    }
+}
+
+void FormatConverter::upmixInPlace(int16_t* buffer, size_t frames) {
+    size_t i = frames;
+    while (i > 0) {
+        i--;
+        buffer[2 * i + 1] = buffer[i];
+        buffer[2 * i] = buffer[i];
+    }
+}
+
+size_t FormatConverter::process(const int16_t* in, size_t inFrames, int16_t* out, size_t outFrames,
+                                size_t* consumedFrames) {
+    size_t consumed = 0;
+    size_t produced = 0;
+
+    if (!in || !out || _inChannels == 0) {
+        if (consumedFrames) {
+            *consumedFrames = 0;
+        }
+        return 0;
+    }
+
+    if (_inChannels == _outChannels) {
+        // Same layout: resample (or copy) straight through
+        produced = _resampler.process(in, inFrames, out, outFrames, &consumed);
+    } else if (_inChannels > _outChannels) {
+        // Downmix a small block on the stack, then resample mono
+        int16_t mono[MIX_BLOCK_FRAMES];
+        while (consumed < inFrames && produced < outFrames) {
+            size_t block = inFrames - consumed;
+            if (block > MIX_BLOCK_FRAMES) {
+                block = MIX_BLOCK_FRAMES;
+            }
+            downmix(in + consumed * 2, mono, block);
+
+            size_t used = 0;
+            produced += _resampler.process(mono, block, out + produced, outFrames - produced, &used);
+            consumed += used;
+            if (used < block) {
+                break;  // Output full
+            }
+        }
+    } else {
+        // Resample mono into the front of the output, then spread to stereo
+        produced = _resampler.process(in, inFrames, out, outFrames, &consumed);
+        upmixInPlace(out, produced);
+    }
+
+    if (consumedFrames) {
+        *consumedFrames = consumed;
+    }
+    return produced;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Resampler.h"
+
+/**
+ * FormatConverter - channel mixer and sample-rate converter for int16 PCM
+ *
+ * Adapts a source stream (e.g. decoded MP3) to the output format of the
+ * speaker: stereo is averaged down to mono, mono is duplicated to stereo,
+ * and the sample rate is converted by a polyphase Resampler. Resampling
+ * runs on the narrower side of the channel change, so a downmix is mixed
+ * first and an upmix is duplicated last. State is carried across calls so
+ * a stream can be converted block by block.
+ *
+ * process() stops when either the input is consumed or the output is full
+ * and reports how much input it used, so output can go straight into a
+ * fixed-size slot or ring region.
+ */
+class FormatConverter {
+public:
+    static const size_t MAX_CHANNELS = 2;
+
+    FormatConverter();
+
+    /**
+     * Configure source and destination formats and reset state
+     *
+     * @param inRate Source sample rate in Hz
+     * @param inChannels Source channel count (1 or 2)
+     * @param outRate Destination sample rate in Hz
+     * @param outChannels Destination channel count (1 or 2)
+     * @param quality Resampler quality when the rates differ
+     * @return true if the formats are supported
+     */
+    bool configure(uint32_t inRate, size_t inChannels, uint32_t outRate, size_t outChannels,
+                   Resampler::Quality quality = Resampler::QUALITY_MEDIUM);
+
+    /**
+     * Drop carried-over state (call between streams)
+     */
+    void reset();
+
+    /**
+     * Check whether input passes through unchanged
+     *
+     * @return true if source and destination formats match
+     */
+    bool isPassthrough() const;
+
+    /**
+     * Check whether the converter is set up for a given source format
+     *
+     * @param inRate Source sample rate in Hz
+     * @param inChannels Source channel count
+     * @return true if configured for this source
+     */
+    bool matchesSource(uint32_t inRate, size_t inChannels) const;
+
+    /**
+     * Convert a block of interleaved frames
+     *
+     * @param in Input frames (interleaved, source format)
+     * @param inFrames Number of input frames
+     * @param out Output buffer (interleaved, destination format)
+     * @param outFrames Output capacity in frames
+     * @param consumedFrames Output for number of input frames used
+     * @return Number of output frames produced
+     */
+    size_t process(const int16_t* in, size_t inFrames, int16_t* out, size_t outFrames,
+                   size_t* consumedFrames);
+
+    size_t getInputChannels() const { return _inChannels; }
+    size_t getOutputChannels() const { return _outChannels; }
+
+    /**
+     * Get the silent input that pushes the last source frame out of the resampler
+     *
+     * @return Frames to feed after the end of a stream, 0 when not resampling
+     */
+    size_t getFlushFrames() const { return _resampler.isPassthrough() ? 0 : _resampler.getTaps(); }
+    size_t getAllocationCount() const { return _resampler.getAllocationCount(); }
+
+private:
+    static const size_t MIX_BLOCK_FRAMES = 64;
+
+    uint32_t _inRate;
+    uint32_t _outRate;
+    size_t _inChannels;
+    size_t _outChannels;
+    Resampler _resampler;
+
+    /**
+     * Average stereo frames down to mono
+     */
+    static void downmix(const int16_t* in, int16_t* out, size_t frames);
+
+    /**
+     * Duplicate mono samples to stereo, in place (back to front)
+     */
+    static void upmixInPlace(int16_t* buffer, size_t frames);
+};
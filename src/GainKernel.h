@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * GainKernel - saturating Q15 fixed-point gain with click-free ramping
+ *
+ * Gains are Q15 values held in an int32 (32768 = unity) so gains above
+ * unity are possible; results saturate to the int16 range instead of
+ * wrapping. Samples are processed in blocks of BLOCK_SAMPLES, which matches
+ * one 128-bit ESP32-S3 PIE vector of int16 lanes. When the target gain
+ * changes, the applied gain ramps linearly towards it one block at a time
+ * so volume changes do not produce zipper noise.
+ *
+ * setGain() may be called from a different task than process(); no
+ * platform dependency so the kernel also builds and runs on the host.
+ */
+class GainKernel {
+public:
+    static const int32_t UNITY_Q15 = 32768;
+    static const int32_t MAX_GAIN_Q15 = 65535;  // Just under 2.0 (+6 dB), keeps products in int32
+    static const size_t BLOCK_SAMPLES = 8;      // One PIE vector of int16
+    static const size_t DEFAULT_RAMP_SAMPLES = 256;
+
+    GainKernel();
+
+    /**
+     * Set target gain, the applied gain ramps towards it
+     *
+     * @param gain Linear gain (0.0 to ~2.0)
+     */
+    void setGain(float gain);
+
+    /**
+     * Jump to a gain immediately without ramping
+     *
+     * @param gain Linear gain (0.0 to ~2.0)
+     */
+    void resetGain(float gain);
+
+    /**
+     * Get target gain
+     *
+     * @return Linear gain
+     */
+    float getGain() const;
+
+    /**
+     * Set ramp length used for gain changes
+     *
+     * @param samples Ramp length in samples (rounded up to whole blocks)
+     */
+    void setRampLength(size_t samples);
+
+    /**
+     * Check whether a gain ramp is still in progress
+     *
+     * @return true while ramping
+     */
+    bool isRamping() const { return _rampBlocksLeft > 0; }
+
+    /**
+     * Apply the current gain (with ramping) to a buffer
+     *
+     * Source and destination may be the same buffer.
+     *
+     * @param src Input samples
+     * @param dst Output samples
+     * @param count Number of samples
+     */
+    void process(const int16_t* src, int16_t* dst, size_t count);
+
+    /**
+     * Apply a constant gain using the block (vector-friendly) path
+     *
+     * @param src Input samples
+     * @param dst Output samples (may equal src)
+     * @param count Number of samples
+     * @param gainQ15 Q15 gain
+     */
+    static void applyBlocks(const int16_t* src, int16_t* dst, size_t count, int32_t gainQ15);
+
+    /**
+     * Apply a constant gain one sample at a time (reference path)
+     *
+     * @param src Input samples
+     * @param dst Output samples (may equal src)
+     * @param count Number of samples
+     * @param gainQ15 Q15 gain
+     */
+    static void applyScalar(const int16_t* src, int16_t* dst, size_t count, int32_t gainQ15);
+
+    /**
+     * Convert linear gain to clamped Q15
+     *
+     * @param gain Linear gain
+     * @return Q15 gain
+     */
+    static int32_t toQ15(float gain);
+
+private:
+    std::atomic<int32_t> _targetQ15;
+    int32_t _currentQ15;
+    int32_t _rampTargetQ15;
+    int32_t _rampStepQ15;
+    size_t _rampBlocksLeft;
+    size_t _rampBlocks;
+};
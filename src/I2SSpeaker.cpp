@@ -1,14 +1,34 @@
 #include "I2SSpeaker.h"
+#include "Oscillator.h"
 #include <cstring>
 #include <cmath>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <esp_attr.h>
+#include <soc/soc_caps.h>
 
 const char* I2SSpeaker::TAG = "I2SSpeaker";
 
+const I2SSpeaker::DmaConfig I2SSpeaker::DMA_LOW_LATENCY(2, 32);
+const I2SSpeaker::DmaConfig I2SSpeaker::DMA_BALANCED(6, 240);
+const I2SSpeaker::DmaConfig I2SSpeaker::DMA_STREAMING(12, 480);
+
+// Largest DMA descriptor buffer supported by the I2S driver
+static const size_t DMA_DESCRIPTOR_MAX_BYTES = 4092;
+
+#if SOC_I2S_HW_VERSION_1
+// ESP32/ESP32-S2 move 24-bit data through the FIFO in 32-bit words, left-justified
+static const bool PACKED_24BIT = false;
+#else
+static const bool PACKED_24BIT = true;
+#endif
+
 I2SSpeaker::I2SSpeaker(gpio_num_t dataPin, gpio_num_t clockPin, gpio_num_t wordSelectPin, 
                        i2s_port_t portNum)
     : _dataPin(dataPin), _clockPin(clockPin), _wordSelectPin(wordSelectPin), _portNum(portNum),
       _sampleRate(16000), _bitsPerSample(I2S_DATA_BIT_WIDTH_16BIT), _channelMode(I2S_SLOT_MODE_STEREO),
-      _txHandle(nullptr), _initialized(false), _active(false) {
+      _txHandle(nullptr), _writeSlot(nullptr), _writeSlotSize(0), _writeSlotAcquired(false),
+      _initialized(false), _active(false), _playing(false) {
     
     ESP_LOGI(TAG, "I2SSpeaker created for port %d, pins: DATA=%d, CLK=%d, WS=%d", 
              _portNum, _dataPin, _clockPin, _wordSelectPin);
@@ -23,12 +43,17 @@ I2SSpeaker::~I2SSpeaker() {
         i2s_del_channel(_txHandle);
         _txHandle = nullptr;
     }
+
+    if (_writeSlot) {
+        heap_caps_free(_writeSlot);
+        _writeSlot = nullptr;
+    }
     
     ESP_LOGI(TAG, "I2SSpeaker destroyed");
 }
 
 esp_err_t I2SSpeaker::init(uint32_t sampleRate, i2s_data_bit_width_t bitsPerSample, 
-                          i2s_slot_mode_t channels) {
+                          i2s_slot_mode_t channels, const DmaConfig& dmaConfig) {
     if (_initialized) {
         ESP_LOGW(TAG, "Already initialized");
         return ESP_OK;
@@ -38,11 +63,21 @@ esp_err_t I2SSpeaker::init(uint32_t sampleRate, i2s_data_bit_width_t bitsPerSamp
     _bitsPerSample = bitsPerSample;
     _channelMode = channels;
 
+    // Keep each descriptor within the driver limit for this frame size
+    size_t frameBytes = getChannelCount() * getBytesPerSample();
+    _telemetry.setFrameBytes(frameBytes);
+    _dmaConfig = dmaConfig;
+    _dmaConfig.descriptorCount = _max(_dmaConfig.descriptorCount, (uint32_t)2);
+    _dmaConfig.framesPerDescriptor = constrain(_dmaConfig.framesPerDescriptor, (uint32_t)8, 
+                                               (uint32_t)(DMA_DESCRIPTOR_MAX_BYTES / frameBytes));
+
     ESP_LOGI(TAG, "Initializing I2S Standard: %lu Hz, %d-bit, %s", 
              _sampleRate, 
              (_bitsPerSample == I2S_DATA_BIT_WIDTH_16BIT) ? 16 : 
              (_bitsPerSample == I2S_DATA_BIT_WIDTH_24BIT) ? 24 : 32,
              (_channelMode == I2S_SLOT_MODE_MONO) ? "mono" : "stereo");
+    ESP_LOGI(TAG, "DMA: %lu x %lu frames, output latency %lu us", 
+             _dmaConfig.descriptorCount, _dmaConfig.framesPerDescriptor, getOutputLatencyUs());
 
     esp_err_t ret = configureChannel();
     if (ret != ESP_OK) {
@@ -50,6 +85,13 @@ esp_err_t I2SSpeaker::init(uint32_t sampleRate, i2s_data_bit_width_t bitsPerSamp
         return ret;
     }
 
+    ret = allocateWriteSlot();
+    if (ret != ESP_OK) {
+        i2s_del_channel(_txHandle);
+        _txHandle = nullptr;
+        return ret;
+    }
+
     _initialized = true;
     ESP_LOGI(TAG, "I2S Standard initialized successfully");
     return ESP_OK;
@@ -58,7 +100,9 @@ esp_err_t I2SSpeaker::init(uint32_t sampleRate, i2s_data_bit_width_t bitsPerSamp
 esp_err_t I2SSpeaker::configureChannel() {
     // Create I2S TX channel
     i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(_portNum, I2S_ROLE_MASTER);
-    chan_cfg.auto_clear = false; // Auto clear DMA buffer when TX underflow
+    chan_cfg.auto_clear = true; // Driver zeroes sent descriptors, so underflow plays silence
+    chan_cfg.dma_desc_num = _dmaConfig.descriptorCount;
+    chan_cfg.dma_frame_num = _dmaConfig.framesPerDescriptor;
     
     esp_err_t ret = i2s_new_channel(&chan_cfg, &_txHandle, nullptr);
     if (ret != ESP_OK) {
@@ -69,7 +113,7 @@ esp_err_t I2SSpeaker::configureChannel() {
     // Configure I2S Standard
     i2s_std_config_t std_cfg = {
         .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(_sampleRate),
-        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(_bitsPerSample, _channelMode),
+        .slot_cfg = slotConfig(_channelMode),
         .gpio_cfg = {
             .mclk = I2S_GPIO_UNUSED,    // Not using MCLK
             .bclk = _clockPin,
@@ -92,10 +136,55 @@ esp_err_t I2SSpeaker::configureChannel() {
         return ret;
     }
 
+    // Telemetry callbacks must be registered before the channel is enabled
+    i2s_event_callbacks_t callbacks = {};
+    callbacks.on_sent = onSentCallback;
+    callbacks.on_send_q_ovf = onSendQueueOverflowCallback;
+    ret = i2s_channel_register_event_callback(_txHandle, &callbacks, &_telemetry);
+    if (ret != ESP_OK) {
+        // Playback still works, only telemetry is lost
+        ESP_LOGW(TAG, "Failed to register I2S event callbacks: %s", esp_err_to_name(ret));
+    }
+
     ESP_LOGI(TAG, "I2S channel configured successfully");
     return ESP_OK;
 }
 
+i2s_std_slot_config_t I2SSpeaker::slotConfig(i2s_slot_mode_t channels) const {
+    i2s_std_slot_config_t slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(_bitsPerSample, channels);
+    if (_bitsPerSample == I2S_DATA_BIT_WIDTH_24BIT && !PACKED_24BIT) {
+        // 24-bit data in 32-bit slots, matching the 4-byte sample containers
+        slot_cfg.slot_bit_width = I2S_SLOT_BIT_WIDTH_32BIT;
+        slot_cfg.ws_width = 32;
+    }
+    return slot_cfg;
+}
+
+esp_err_t I2SSpeaker::allocateWriteSlot() {
+    size_t slotSize = _dmaConfig.framesPerDescriptor * getChannelCount() * getBytesPerSample();
+
+    if (_writeSlot && _writeSlotSize == slotSize) {
+        return ESP_OK;
+    }
+
+    if (_writeSlot) {
+        heap_caps_free(_writeSlot);
+        _writeSlot = nullptr;
+        _writeSlotSize = 0;
+    }
+
+    // Keep the slot in internal RAM, the driver copies from it on every commit
+    _writeSlot = (uint8_t*)heap_caps_malloc(slotSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!_writeSlot) {
+        ESP_LOGE(TAG, "Failed to allocate write slot (%u bytes)", (unsigned)slotSize);
+        return ESP_ERR_NO_MEM;
+    }
+
+    _writeSlotSize = slotSize;
+    _writeSlotAcquired = false;
+    return ESP_OK;
+}
+
 esp_err_t I2SSpeaker::start() {
     if (!_initialized) {
         ESP_LOGE(TAG, "Speaker not initialized");
@@ -134,6 +223,71 @@ esp_err_t I2SSpeaker::stop() {
     return ESP_OK;
 }
 
+esp_err_t I2SSpeaker::reconfigure(uint32_t sampleRate, i2s_slot_mode_t channels) {
+    if (!_initialized) {
+        ESP_LOGE(TAG, "Speaker not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (_writeSlotAcquired || _playing) {
+        ESP_LOGE(TAG, "Cannot reconfigure while writing");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (sampleRate == _sampleRate && channels == _channelMode) {
+        return ESP_OK;
+    }
+
+    // Clock and slot can only be reprogrammed on a disabled channel
+    bool wasActive = _active;
+    esp_err_t ret = stop();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(sampleRate);
+    ret = i2s_channel_reconfig_std_clock(_txHandle, &clk_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to reconfigure I2S clock: %s", esp_err_to_name(ret));
+        if (wasActive) {
+            start();
+        }
+        return ret;
+    }
+
+    i2s_std_slot_config_t slot_cfg = slotConfig(channels);
+    ret = i2s_channel_reconfig_std_slot(_txHandle, &slot_cfg);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to reconfigure I2S slots: %s", esp_err_to_name(ret));
+        // Put the old clock back so the speaker keeps its previous format
+        i2s_std_clk_config_t old_clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(_sampleRate);
+        i2s_channel_reconfig_std_clock(_txHandle, &old_clk_cfg);
+        if (wasActive) {
+            start();
+        }
+        return ret;
+    }
+
+    _sampleRate = sampleRate;
+    _channelMode = channels;
+
+    // The driver shrinks the DMA frame the same way if it no longer fits
+    size_t frameBytes = getChannelCount() * getBytesPerSample();
+    _telemetry.setFrameBytes(frameBytes);
+    _dmaConfig.framesPerDescriptor = _min(_dmaConfig.framesPerDescriptor, 
+                                          (uint32_t)(DMA_DESCRIPTOR_MAX_BYTES / frameBytes));
+
+    ESP_LOGI(TAG, "Reconfigured I2S: %lu Hz, %s", _sampleRate, 
+             (_channelMode == I2S_SLOT_MODE_MONO) ? "mono" : "stereo");
+
+    ret = allocateWriteSlot();
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    return wasActive ? start() : ESP_OK;
+}
+
 esp_err_t I2SSpeaker::writeAudioData(const void* buffer, size_t bufferSize, size_t* bytesWritten, 
                                     uint32_t timeoutMs) {
     if (!_initialized) {
@@ -151,10 +305,18 @@ esp_err_t I2SSpeaker::writeAudioData(const void* buffer, size_t bufferSize, size
         return ESP_ERR_INVALID_ARG;
     }
         
+    size_t written = 0;
     _playing = true;
     if (timeoutMs != portMAX_DELAY) timeoutMs = pdMS_TO_TICKS(timeoutMs);
-    esp_err_t ret = i2s_channel_write(_txHandle, buffer, bufferSize, bytesWritten, 
+    int64_t startUs = esp_timer_get_time();
+    esp_err_t ret = i2s_channel_write(_txHandle, buffer, bufferSize, &written, 
                                      timeoutMs);
+    _telemetry.recordWrite((uint32_t)(esp_timer_get_time() - startUs));
+    _telemetry.onQueued(written);
+
+    if (bytesWritten) {
+        *bytesWritten = written;
+    }
     
     if (ret != ESP_OK && ret != ESP_ERR_TIMEOUT) {
         ESP_LOGE(TAG, "Failed to write audio data: %s", esp_err_to_name(ret));
@@ -171,13 +333,87 @@ esp_err_t I2SSpeaker::writeSamples(const int16_t* buffer, size_t sampleCount, si
         return ESP_ERR_INVALID_ARG;
     }
 
-    size_t bytesToWrite = sampleCount * sizeof(int16_t);
-    size_t bytesWritten;
+    size_t bytesPerSample = getBytesPerSample();
+
+    // Native 16-bit: hand the caller's buffer to the driver directly
+    if (bytesPerSample == sizeof(int16_t)) {
+        size_t bytesToWrite = sampleCount * sizeof(int16_t);
+        size_t bytesWritten = 0;
+
+        esp_err_t ret = writeAudioData(buffer, bytesToWrite, &bytesWritten, timeoutMs);
+        
+        if (samplesWritten) {
+            *samplesWritten = bytesWritten / sizeof(int16_t);
+        }
+
+        return ret;
+    }
+
+    // Wider slots: widen one DMA frame at a time through the write slot
+    size_t written = 0;
+    esp_err_t ret = ESP_OK;
+
+    while (written < sampleCount) {
+        size_t capacity;
+        int16_t* slot = (int16_t*)acquireBuffer(&capacity, timeoutMs);
+        if (!slot) {
+            ret = ESP_ERR_INVALID_STATE;
+            break;
+        }
+
+        size_t chunk = _min(sampleCount - written, capacity / sizeof(int16_t));
+        memcpy(slot, buffer + written, chunk * sizeof(int16_t));
+
+        if (!commitBuffer(chunk * sizeof(int16_t), timeoutMs)) {
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        }
+        written += chunk;
+    }
 
-    esp_err_t ret = writeAudioData(buffer, bytesToWrite, &bytesWritten, timeoutMs);
-    
     if (samplesWritten) {
-        *samplesWritten = bytesWritten / sizeof(int16_t);
+        *samplesWritten = written;
+    }
+
+    return ret;
+}
+
+esp_err_t I2SSpeaker::writeSamples(const float* buffer, size_t sampleCount, size_t* samplesWritten, 
+                                  uint32_t timeoutMs) {
+    if (!buffer || sampleCount == 0) {
+        ESP_LOGE(TAG, "Invalid buffer or sample count");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Hold the write slot for the whole loop, so no other producer renders into it
+    if (!acquireBuffer(nullptr, timeoutMs)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    size_t bytesPerSample = getBytesPerSample();
+    size_t slotSamples = _writeSlotSize / bytesPerSample;
+    size_t written = 0;
+    esp_err_t ret = ESP_OK;
+
+    // Convert straight into the write slot at the native width
+    while (written < sampleCount) {
+        size_t chunk = _min(sampleCount - written, slotSamples);
+        SampleConverter::fromFloat(buffer + written, _writeSlot, chunk, bytesPerSample, &_dither,
+                                   (_bitsPerSample == I2S_DATA_BIT_WIDTH_24BIT) ? 24 : 0);
+
+        size_t bytesWritten = 0;
+        ret = writeAudioData(_writeSlot, chunk * bytesPerSample, &bytesWritten, timeoutMs);
+        written += bytesWritten / bytesPerSample;
+
+        if (ret != ESP_OK || bytesWritten < chunk * bytesPerSample) {
+            break;
+        }
+    }
+
+    _writeSlotAcquired = false;
+
+    if (samplesWritten) {
+        *samplesWritten = written;
     }
 
     return ret;
@@ -194,6 +430,50 @@ int I2SSpeaker::writeSamples(const int16_t* buffer, size_t sampleCount, uint32_t
     }
 }
 
+void* I2SSpeaker::acquireBuffer(size_t* capacity, uint32_t timeoutMs) {
+    (void)timeoutMs;
+
+    if (!_initialized || !_active || !_writeSlot) {
+        ESP_LOGE(TAG, "Speaker not ready for writing");
+        return nullptr;
+    }
+
+    // Claimed atomically: producers on other tasks may race for the slot
+    if (_writeSlotAcquired.exchange(true)) {
+        ESP_LOGE(TAG, "Write slot already acquired");
+        return nullptr;
+    }
+
+    if (capacity) {
+        *capacity = _writeSlotSize / getBytesPerSample() * sizeof(int16_t);
+    }
+    return _writeSlot;
+}
+
+bool I2SSpeaker::commitBuffer(size_t bytes, uint32_t timeoutMs) {
+    if (!_writeSlotAcquired) {
+        ESP_LOGE(TAG, "Commit without acquired write slot");
+        return false;
+    }
+
+    size_t bytesPerSample = getBytesPerSample();
+    size_t sampleCount = _min(bytes / sizeof(int16_t), _writeSlotSize / bytesPerSample);
+
+    bool result = true;
+    if (sampleCount > 0) {
+        // Producers render int16; widen in place for 24/32-bit slots
+        SampleConverter::expandInt16InPlace(_writeSlot, sampleCount, bytesPerSample);
+
+        size_t nativeBytes = sampleCount * bytesPerSample;
+        size_t bytesWritten = 0;
+        esp_err_t ret = writeAudioData(_writeSlot, nativeBytes, &bytesWritten, timeoutMs);
+        result = (ret == ESP_OK && bytesWritten == nativeBytes);
+    }
+
+    _writeSlotAcquired = false;
+    return result;
+}
+
 int I2SSpeaker::playTone(int frequency, int duration, float amplitude) {
     if (!_initialized) {
         ESP_LOGE(TAG, "Speaker not initialized");
@@ -204,34 +484,38 @@ int I2SSpeaker::playTone(int frequency, int duration, float amplitude) {
     frequency = constrain(frequency, 20, 20000);
     amplitude = constrain(amplitude, 0.0f, 1.0f);
 
-    // Calculate buffer size needed
-    size_t samplesNeeded = (_sampleRate * duration) / 1000;
-    size_t channelCount = getChannelCount();
-    size_t totalSamples = samplesNeeded * channelCount;
-
-    // Allocate buffer
-    int16_t* toneBuffer = (int16_t*)malloc(totalSamples * sizeof(int16_t));
-    if (!toneBuffer) {
-        ESP_LOGE(TAG, "Failed to allocate tone buffer");
-        return -1;
+    if (!_active) {
+        start();
     }
 
-    // Generate sine wave
-    size_t samplesGenerated = generateSineWave(frequency, duration, amplitude, 
-                                              toneBuffer, totalSamples);
+    Oscillator oscillator(_sampleRate, Oscillator::SINE);
+    oscillator.setAmplitude(amplitude);
+    oscillator.setFrequency(frequency);
 
-    // Play the tone
-    int result = -1;
-    if (samplesGenerated > 0) {
-        if (!_active) {
-            start();
+    // Render the tone slot by slot instead of allocating the whole clip
+    size_t channelCount = getChannelCount();
+    size_t framesLeft = (_sampleRate * duration) / 1000;
+    int samplesPlayed = 0;
+
+    while (framesLeft > 0) {
+        size_t capacity;
+        int16_t* slot = (int16_t*)acquireBuffer(&capacity, 1000);
+        if (!slot) {
+            return -1;
         }
-        
-        result = writeSamples(toneBuffer, samplesGenerated, 1000);
+
+        size_t frames = _min(framesLeft, capacity / (channelCount * sizeof(int16_t)));
+        oscillator.render(slot, frames, channelCount);
+
+        if (!commitBuffer(frames * channelCount * sizeof(int16_t), 1000)) {
+            return -1;
+        }
+
+        framesLeft -= frames;
+        samplesPlayed += frames * channelCount;
     }
 
-    free(toneBuffer);
-    return result;
+    return samplesPlayed;
 }
 
 size_t I2SSpeaker::generateSineWave(int frequency, int duration, float amplitude, 
@@ -244,18 +528,10 @@ size_t I2SSpeaker::generateSineWave(int frequency, int duration, float amplitude
     size_t samplesPerChannel = bufferSize / channelCount;
     size_t actualSamples = _min(samplesPerChannel, (_sampleRate * duration) / 1000);
 
-    float angularFreq = 2.0f * PI * frequency / _sampleRate;
-    int16_t maxAmplitude = (int16_t)(amplitude * 32767);
-
-    for (size_t i = 0; i < actualSamples; i++) {
-        float sineValue = sin(angularFreq * i);
-        int16_t sample = (int16_t)(sineValue * maxAmplitude);
-        
-        // Fill all channels with the same sample
-        for (size_t ch = 0; ch < channelCount; ch++) {
-            buffer[i * channelCount + ch] = sample;
-        }
-    }
+    Oscillator oscillator(_sampleRate, Oscillator::SINE);
+    oscillator.setAmplitude(amplitude);
+    oscillator.setFrequency(frequency);
+    oscillator.render(buffer, actualSamples, channelCount);
 
     return actualSamples * channelCount;
 }
@@ -284,6 +560,39 @@ i2s_slot_mode_t I2SSpeaker::getChannelMode() const {
     return _channelMode;
 }
 
+I2SSpeaker::DmaConfig I2SSpeaker::getDmaConfig() const {
+    return _dmaConfig;
+}
+
+uint32_t I2SSpeaker::getOutputLatencyUs() const {
+    if (_sampleRate == 0) {
+        return 0;
+    }
+    uint64_t queuedFrames = (uint64_t)_dmaConfig.descriptorCount * _dmaConfig.framesPerDescriptor;
+    return (uint32_t)(queuedFrames * 1000000ULL / _sampleRate);
+}
+
+I2SSpeaker::Stats I2SSpeaker::getStats() const {
+    return _telemetry.snapshot();
+}
+
+void I2SSpeaker::resetStats() {
+    _telemetry.reset();
+}
+
+bool IRAM_ATTR I2SSpeaker::onSentCallback(i2s_chan_handle_t handle, i2s_event_data_t* event, void* userCtx) {
+    (void)handle;
+    static_cast<PlaybackTelemetry*>(userCtx)->onSent(event->size);
+    return false;
+}
+
+bool IRAM_ATTR I2SSpeaker::onSendQueueOverflowCallback(i2s_chan_handle_t handle, i2s_event_data_t* event, void* userCtx) {
+    (void)handle;
+    (void)event;
+    static_cast<PlaybackTelemetry*>(userCtx)->onQueueOverflow();
+    return false;
+}
+
 size_t I2SSpeaker::calculateBufferSize(uint32_t durationMs) const {
     size_t samplesPerMs = _sampleRate / 1000;
     size_t totalSamples = samplesPerMs * durationMs;
@@ -298,7 +607,7 @@ size_t I2SSpeaker::getBytesPerSample() const {
         case I2S_DATA_BIT_WIDTH_16BIT:
             return 2;
         case I2S_DATA_BIT_WIDTH_24BIT:
-            return 3;
+            return PACKED_24BIT ? 3 : 4;
         case I2S_DATA_BIT_WIDTH_32BIT:
             return 4;
         default:
@@ -322,18 +631,25 @@ esp_err_t I2SSpeaker::clear() {
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Create a buffer of silence
-    size_t bufferSize = calculateBufferSize(1000); // silence duration on ms
-    uint8_t* silenceBuffer = (uint8_t*)calloc(bufferSize, 1);
-    
-    if (!silenceBuffer) {
-        ESP_LOGE(TAG, "Failed to allocate silence buffer");
-        return ESP_ERR_NO_MEM;
+    // Claim the slot for the silence frame so acquireBuffer() cannot hand it out meanwhile
+    if (_writeSlotAcquired.exchange(true)) {
+        ESP_LOGE(TAG, "Cannot clear while write slot is acquired");
+        return ESP_ERR_INVALID_STATE;
     }
 
+    // auto_clear zeroes every descriptor once it has been sent, so stale audio
+    // can never loop. Only the partially filled tail needs padding: push one
+    // DMA frame of silence from the write slot, waiting at most one DMA period.
+    memset(_writeSlot, 0, _writeSlotSize);
+
+    uint32_t periodMs = (_dmaConfig.framesPerDescriptor * 1000 + _sampleRate - 1) / _sampleRate;
     size_t bytesWritten;
-    esp_err_t ret = writeAudioData(silenceBuffer, bufferSize, &bytesWritten, portMAX_DELAY);
-    
-    free(silenceBuffer);
-    return ret;
+    esp_err_t ret = writeAudioData(_writeSlot, _writeSlotSize, &bytesWritten, _max(periodMs, (uint32_t)1));
+    _writeSlotAcquired.store(false);
+
+    // Silence from here on is intentional, not an underrun
+    _telemetry.markIdle();
+
+    // Queue still full means audio is draining; the driver pads with zeros after it
+    return (ret == ESP_ERR_TIMEOUT) ? ESP_OK : ret;
 }
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <Arduino.h>
+#include <atomic>
 #include "driver/i2s_std.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "AudioSink.h"
+#include "PlaybackTelemetry.h"
+#include "SampleConverter.h"
 
 /**
  * I2SSpeaker class for digital audio output using ESP-IDF v5+ I2S STD API
@@ -13,9 +17,36 @@
  * the legacy I2S driver.
  * 
  * Compatible with audio amplifiers like MAX98357A, PCM5102A, etc.
+ *
+ * Implements AudioSink so producers can render PCM straight into the speaker's
+ * write slot instead of filling a staging buffer of their own.
+ *
+ * Registers the I2S TX event callbacks to keep underrun/overflow telemetry,
+ * readable at any time through getStats().
  */
-class I2SSpeaker {
+class I2SSpeaker : public AudioSink {
 public:
+    /**
+     * DMA buffering configuration
+     * 
+     * More descriptors and frames absorb longer producer stalls at the cost of
+     * output latency. Each descriptor holds at most 4092 bytes; larger frame
+     * counts are reduced to fit at init().
+     */
+    struct DmaConfig {
+        uint32_t descriptorCount;       // Number of DMA descriptors (>= 2)
+        uint32_t framesPerDescriptor;   // Frames per descriptor
+
+        DmaConfig(uint32_t descriptors = 6, uint32_t frames = 240)
+            : descriptorCount(descriptors), framesPerDescriptor(frames) {}
+    };
+
+    static const DmaConfig DMA_LOW_LATENCY;  // 2 x 32 frames, under 5 ms at 16 kHz and up (UI sounds)
+    static const DmaConfig DMA_BALANCED;     // 6 x 240 frames, ESP-IDF default
+    static const DmaConfig DMA_STREAMING;    // 12 x 480 frames, deep buffering for network audio
+
+    using Stats = PlaybackTelemetry::Snapshot;
+
     /**
      * Constructor for I2S Standard speaker
      * 
@@ -38,10 +69,12 @@ public:
      * @param sampleRate Sample rate in Hz (8000, 16000, 22050, 44100, 48000)
      * @param bitsPerSample Bits per sample (16, 24, or 32)
      * @param channels Number of channels (1 for mono, 2 for stereo)
+     * @param dmaConfig DMA buffering (DMA_LOW_LATENCY, DMA_BALANCED, DMA_STREAMING or custom)
      * @return ESP_OK if successful, error code otherwise
      */
     esp_err_t init(uint32_t sampleRate = 16000, i2s_data_bit_width_t bitsPerSample = I2S_DATA_BIT_WIDTH_16BIT, 
-                   i2s_slot_mode_t channels = I2S_SLOT_MODE_MONO);
+                   i2s_slot_mode_t channels = I2S_SLOT_MODE_MONO, 
+                   const DmaConfig& dmaConfig = DMA_BALANCED);
 
     /**
      * Start the I2S channel (begin transmitting data)
@@ -57,6 +90,19 @@ public:
      */
     esp_err_t stop();
 
+    /**
+     * Change sample rate and channel mode of an initialized speaker
+     * 
+     * The channel is briefly disabled to reprogram its clock and slots and
+     * the write slot is resized; it is re-enabled if it was running. Only
+     * call while no producer is writing (the write slot must not be held).
+     * 
+     * @param sampleRate New sample rate in Hz
+     * @param channels New channel mode (mono/stereo)
+     * @return ESP_OK if successful, error code otherwise
+     */
+    esp_err_t reconfigure(uint32_t sampleRate, i2s_slot_mode_t channels);
+
     /**
      * Write audio samples to the speaker
      * 
@@ -72,6 +118,9 @@ public:
     /**
      * Write audio samples from an int16_t buffer (convenience method)
      * 
+     * With a 24/32-bit configuration the samples are widened to the slot
+     * width through the write slot, one DMA frame at a time.
+     * 
      * @param buffer Buffer containing audio samples (int16_t)
      * @param sampleCount Number of samples to write
      * @param samplesWritten Pointer to store actual samples written
@@ -91,6 +140,46 @@ public:
      */
     int writeSamples(const int16_t* buffer, size_t sampleCount, uint32_t timeoutMs = 100);
 
+    /**
+     * Write float audio samples (-1.0 to 1.0)
+     * 
+     * Converted to the configured bit width through the write slot; narrowing
+     * to 16 or 24 bits is TPDF-dithered.
+     * 
+     * @param buffer Buffer containing audio samples (float)
+     * @param sampleCount Number of samples to write
+     * @param samplesWritten Pointer to store actual samples written
+     * @param timeoutMs Timeout in milliseconds
+     * @return ESP_OK if successful, error code otherwise
+     */
+    esp_err_t writeSamples(const float* buffer, size_t sampleCount, size_t* samplesWritten, 
+                          uint32_t timeoutMs = 100);
+
+    /**
+     * Acquire the speaker's write slot for zero-copy rendering
+     *
+     * The slot is sized to one DMA frame and allocated once in init(), so
+     * producers can render into it without any per-write heap allocation.
+     * Returns nullptr if the speaker is not started or the slot is already held.
+     *
+     * Producers always render int16 PCM; capacity is reported in int16 bytes
+     * and commitBuffer() widens the samples in place for 24/32-bit output.
+     *
+     * @param capacity Output for slot size in bytes of int16 PCM
+     * @param timeoutMs Unused, the slot is always available once released
+     * @return Pointer to the slot, or nullptr on error
+     */
+    void* acquireBuffer(size_t* capacity, uint32_t timeoutMs = 100) override;
+
+    /**
+     * Queue the rendered part of the write slot to the I2S channel
+     *
+     * @param bytes Number of bytes rendered into the slot
+     * @param timeoutMs Timeout in milliseconds
+     * @return true if all bytes were queued
+     */
+    bool commitBuffer(size_t bytes, uint32_t timeoutMs = 100) override;
+
     /**
      * Play a simple tone at specified frequency
      * 
@@ -122,7 +211,7 @@ public:
      * 
      * @return Sample rate in Hz
      */
-    uint32_t getSampleRate() const;
+    uint32_t getSampleRate() const override;
 
     /**
      * Get current bits per sample
@@ -138,6 +227,39 @@ public:
      */
     i2s_slot_mode_t getChannelMode() const;
 
+    /**
+     * Get DMA configuration in use (after size limits were applied)
+     * 
+     * @return DMA configuration
+     */
+    DmaConfig getDmaConfig() const;
+
+    /**
+     * Get output latency added by the DMA queue
+     * 
+     * Time for a sample committed now to reach the pins when every
+     * descriptor is queued ahead of it.
+     * 
+     * @return Latency in microseconds
+     */
+    uint32_t getOutputLatencyUs() const;
+
+    /**
+     * Get playback telemetry
+     * 
+     * Frames sent, underruns, queue overflows, longest write block and a
+     * write latency histogram (bucket i counts writes below 250us << i).
+     * Cheap to call; counters are updated from the I2S interrupt.
+     * 
+     * @return Counter snapshot
+     */
+    Stats getStats() const;
+
+    /**
+     * Reset playback telemetry counters
+     */
+    void resetStats();
+
     /**
      * Calculate the optimal buffer size for given duration
      * 
@@ -164,11 +286,26 @@ public:
      * 
      * @return Number of channels (1 or 2)
      */
-    size_t getChannelCount() const;
+    size_t getChannelCount() const override;
+
+    /**
+     * Get bytes per sample based on bit width
+     * 
+     * 24-bit samples take 3 bytes, except on ESP32/ESP32-S2, where the
+     * driver expects them left-justified in 4-byte containers.
+     * 
+     * @return Bytes per sample
+     */
+    size_t getBytesPerSample() const;
 
     /**
      * Clear Speaker buffer
      * 
+     * Pads the output with one DMA frame of silence. The channel runs with
+     * auto-clear, so descriptors are zeroed by the driver once sent and no
+     * stale audio repeats on underflow. Returns within one DMA period and
+     * does not allocate.
+     * 
      * @return ESP_OK if successful, error code otherwise
      */
     esp_err_t clear();
@@ -190,6 +327,20 @@ private:
     // I2S handles
     i2s_chan_handle_t _txHandle;
 
+    // Write slot for acquire/commit rendering
+    uint8_t* _writeSlot;
+    size_t _writeSlotSize;
+    std::atomic<bool> _writeSlotAcquired;
+
+    // DMA configuration
+    DmaConfig _dmaConfig;
+
+    // Output health counters, fed from writes and the TX interrupt
+    PlaybackTelemetry _telemetry;
+
+    // Dither state for float input narrowed to 16/24-bit
+    SampleConverter::Dither _dither;
+
     // State flags
     bool _initialized;
     bool _active;
@@ -203,9 +354,27 @@ private:
     esp_err_t configureChannel();
 
     /**
-     * Get bytes per sample based on bit width
+     * Build the standard-mode slot configuration for the current bit width
      * 
-     * @return Bytes per sample
+     * @param channels Mono or stereo
+     * @return Slot configuration
      */
-    size_t getBytesPerSample() const;
+    i2s_std_slot_config_t slotConfig(i2s_slot_mode_t channels) const;
+
+    /**
+     * Allocate the write slot to match the configured DMA frame
+     * 
+     * @return ESP_OK if successful, error code otherwise
+     */
+    esp_err_t allocateWriteSlot();
+
+    /**
+     * I2S TX "descriptor sent" interrupt callback
+     */
+    static bool onSentCallback(i2s_chan_handle_t handle, i2s_event_data_t* event, void* userCtx);
+
+    /**
+     * I2S TX "send queue overflow" interrupt callback
+     */
+    static bool onSendQueueOverflowCallback(i2s_chan_handle_t handle, i2s_event_data_t* event, void* userCtx);
 };
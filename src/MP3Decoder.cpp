@@ -3,8 +3,11 @@
 
 MP3Decoder::MP3Decoder() 
     : _decoder(nullptr), _initialized(false), _streaming(false),
-      _inputBuffer(nullptr), _outputBuffer(nullptr), _streamBuffer(nullptr),
-      _bytesLeft(0), _readPtr(nullptr), _firstFrame(true) {
+      _inputBuffer(nullptr), _outputBuffer(nullptr), _streamBuffer(nullptr), _allocationCount(0), _source(nullptr),
+      _bytesLeft(0), _readPos(0), _readChunk(DEFAULT_READ_CHUNK), _discardFrames(0),
+      _positionSamples(0), _audioStart(0), _audioBytes(0), _consumedBytes(0),
+      _gapless(false), _trimStart(0), _trimEnd(false), _samplesLeft(0), _firstFrame(true),
+      _maxScanBytes(DEFAULT_MAX_SCAN_BYTES), _maxFrames(DEFAULT_MAX_FRAMES), _frameState(STATE_SYNC) {
 }
 
 MP3Decoder::~MP3Decoder() {
@@ -23,6 +26,10 @@ MP3Decoder::~MP3Decoder() {
     if (_outputBuffer) {
         heap_caps_free(_outputBuffer);
     }
+    
+    if (_streamBuffer) {
+        heap_caps_free(_streamBuffer);
+    }
 }
 
 bool MP3Decoder::init() {
@@ -49,46 +56,77 @@ bool MP3Decoder::init() {
         _decoder = nullptr;
         return false;
     }
+    _allocationCount += 3;
     
     _initialized = true;
     return true;
 }
 
 bool MP3Decoder::decodeFile(const String& filePath, int16_t** pcmBuffer, size_t* pcmSize, MP3Info* info) {
+    return decodeFile(SPIFFS, filePath, pcmBuffer, pcmSize, info);
+}
+
+bool MP3Decoder::decodeFile(fs::FS& fs, const String& filePath, int16_t** pcmBuffer, size_t* pcmSize, MP3Info* info) {
     if (!_initialized) {
         return false;
     }
     
-    // Open file from SPIFFS
-    File file = SPIFFS.open(filePath, "r");
-    if (!file) {
+    FileByteSource file;
+    if (!file.open(fs, filePath)) {
         return false;
     }
     
-    size_t fileSize = file.size();
-    if (fileSize == 0) {
-        file.close();
+    return decodeSource(&file, pcmBuffer, pcmSize, info);
+}
+
+bool MP3Decoder::decodeSource(ByteSource* source, int16_t** pcmBuffer, size_t* pcmSize, MP3Info* info) {
+    if (!_initialized || !source) {
         return false;
     }
     
-    // Allocate buffer for MP3 data
-    uint8_t* mp3Data = (uint8_t*)heap_caps_malloc(fileSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
+    // Allocate the whole stream up front when its size is known, else grow
+    size_t capacity = (source->size() > source->position()) ? source->size() - source->position() : STREAM_BUFFER_SIZE;
+    uint8_t* mp3Data = (uint8_t*)heap_caps_malloc(capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
     if (!mp3Data) {
-        file.close();
         return false;
     }
     
-    // Read entire file into memory
-    size_t bytesRead = file.readBytes((char*)mp3Data, fileSize);
-    file.close();
+    // Read entire stream into memory. A seekable source (file, memory) that
+    // keeps returning nothing has failed; a live source may just be slow.
+    size_t length = 0;
+    uint32_t stalls = 0;
+    while (!source->isEnd()) {
+        if (length == capacity) {
+            uint8_t* grown = (uint8_t*)heap_caps_realloc(mp3Data, capacity * 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
+            if (!grown) {
+                heap_caps_free(mp3Data);
+                return false;
+            }
+            mp3Data = grown;
+            capacity *= 2;
+        }
+        
+        size_t bytesRead = source->read(mp3Data + length, capacity - length);
+        if (bytesRead == 0) {
+            if (source->isSeekable() && ++stalls > READ_STALL_LIMIT) {
+                Serial.printf("MP3 source stopped delivering data at byte %u\n", (unsigned)source->position());
+                heap_caps_free(mp3Data);
+                return false;
+            }
+            vTaskDelay(pdMS_TO_TICKS(1)); // Producer has not caught up yet
+        } else {
+            stalls = 0;
+        }
+        length += bytesRead;
+    }
     
-    if (bytesRead != fileSize) {
+    if (length == 0) {
         heap_caps_free(mp3Data);
         return false;
     }
     
     // Decode the MP3 data
-    bool result = decodeInternal(mp3Data, fileSize, pcmBuffer, pcmSize, info);
+    bool result = decodeInternal(mp3Data, length, pcmBuffer, pcmSize, info);
     
     heap_caps_free(mp3Data);
     return result;
@@ -117,8 +155,14 @@ bool MP3Decoder::decodeInternal(const uint8_t* mp3Data, size_t mp3Size, int16_t*
         return false;
     }
     
-    const uint8_t* readPtr = mp3Data;
-    size_t bytesLeft = mp3Size;
+    // Skip an ID3v2 tag, it may contain sync patterns
+    size_t tagSize = MP3Header::id3v2Size(mp3Data, mp3Size);
+    if (tagSize >= mp3Size) {
+        tagSize = 0;
+    }
+    
+    const uint8_t* readPtr = mp3Data + tagSize;
+    size_t bytesLeft = mp3Size - tagSize;
     size_t pcmOffset = 0;
     size_t totalPCMSamples = 0;
     
@@ -203,78 +247,326 @@ bool MP3Decoder::decodeInternal(const uint8_t* mp3Data, size_t mp3Size, int16_t*
 }
 
 bool MP3Decoder::getFileInfo(const String& filePath, MP3Info* info) {
-    if (!_initialized || !info) {
+    return getFileInfo(SPIFFS, filePath, info);
+}
+
+bool MP3Decoder::getFileInfo(fs::FS& fs, const String& filePath, MP3Info* info) {
+    if (!info) {
         return false;
     }
     
-    // Open file
-    File file = SPIFFS.open(filePath, "r");
-    if (!file) {
+    FileByteSource file;
+    if (!file.open(fs, filePath)) {
         return false;
     }
     
-    size_t fileSize = file.size();
-    if (fileSize == 0) {
-        file.close();
+    return getFileInfo(&file, info);
+}
+
+// Read until length bytes arrived or the source ended; an empty read means
+// "not yet" and is retried, up to READ_STALL_LIMIT times in a row
+size_t MP3Decoder::readFully(ByteSource* source, uint8_t* buffer, size_t length) {
+    size_t total = 0;
+    uint32_t stalls = 0;
+    while (total < length && !source->isEnd()) {
+        size_t bytesRead = source->read(buffer + total, length - total);
+        if (bytesRead > 0) {
+            total += bytesRead;
+            stalls = 0;
+        } else if (++stalls > READ_STALL_LIMIT) {
+            break;
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+    return total;
+}
+
+// Move a source forward to a position, reading through it if it cannot seek
+bool MP3Decoder::skipTo(ByteSource* source, size_t position, uint8_t* scratch, size_t scratchSize) {
+    if (source->isSeekable() || position < source->position()) {
+        return source->seek(position);
+    }
+    while (source->position() < position) {
+        size_t n = _min(position - source->position(), scratchSize);
+        if (readFully(source, scratch, n) < n) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MP3Decoder::getFileInfo(ByteSource* source, MP3Info* info) {
+    if (!source || !info) {
         return false;
     }
     
-    // Read first few KB to get frame info
-    size_t readSize = min(fileSize, (size_t)4096);
-    uint8_t* buffer = (uint8_t*)heap_caps_malloc(readSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
-    if (!buffer) {
-        file.close();
-        return false;
+    size_t start = source->position();
+    uint8_t probe[INFO_PROBE_SIZE];
+    size_t base = start;  // Stream position of probe[0]
+    size_t length = readFully(source, probe, sizeof(probe));
+    
+    // Jump over ID3v2 tags (album art can be hundreds of KB) instead of
+    // searching for a sync word inside them
+    size_t tagSize;
+    bool result = true;
+    while (result && (tagSize = MP3Header::id3v2Size(probe, length)) > 0) {
+        size_t probeEnd = base + length;
+        base += tagSize;
+        if (base < probeEnd) {
+            // A small tag ends inside the probe
+            size_t keep = probeEnd - base;
+            memmove(probe, probe + (length - keep), keep);
+            length = keep + readFully(source, probe + keep, sizeof(probe) - keep);
+        } else {
+            result = skipTo(source, base, probe, sizeof(probe));
+            length = result ? readFully(source, probe, sizeof(probe)) : 0;
+        }
     }
     
-    size_t bytesRead = file.readBytes((char*)buffer, readSize);
-    file.close();
+    MP3Header::Frame frame;
+    MP3Header::VbrInfo vbr;
+    long offset = result ? MP3Header::findFrame(probe, length, &frame) : -1;
+    result = offset >= 0;
+    
+    // A VBR header confirms the frame by itself; otherwise check the
+    // following header when it lies past the probe
+    if (result && !MP3Header::parseVbr(probe + offset, length - offset, frame, &vbr) &&
+        offset + frame.frameSize + MP3Header::HEADER_SIZE > length) {
+        uint8_t header[MP3Header::HEADER_SIZE];
+        MP3Header::Frame nextFrame;
+        result = skipTo(source, base + offset + frame.frameSize, probe, sizeof(probe));
+        size_t bytesRead = result ? readFully(source, header, sizeof(header)) : 0;
+        if (bytesRead == sizeof(header)) {
+            result = MP3Header::parseFrame(header, &nextFrame) && MP3Header::matches(frame, nextFrame);
+        } else {
+            result = result && bytesRead == 0 && source->isEnd();  // Single-frame stream
+        }
+    }
     
-    if (bytesRead == 0) {
-        heap_caps_free(buffer);
-        return false;
+    if (result) {
+        size_t frameStart = base + offset;
+        describe(frame, vbr, (source->size() > frameStart) ? source->size() - frameStart : 0, info);
+    }
+    
+    if (source->isSeekable()) {
+        source->seek(start);
     }
     
-    // Find first frame and get info
-    const uint8_t* readPtr = buffer;
-    size_t bytesLeft = bytesRead;
+    if (result) {
+        // Print MP3 info for debugging
+        Serial.printf("MP3 Info: SampleRate=%d Hz, Channels=%d, BitRate=%d kbps\n", info->sampleRate, info->channels, info->bitRate / 1000);
+    }
+    
+    return result;
+}
+
+bool MP3Decoder::parseInfo(const uint8_t* data, size_t length, size_t streamSize, MP3Info* info) {
+    if (!data || length == 0) {
+        return false;
+    }
     
-    int offset = MP3FindSyncWord((unsigned char*)readPtr, bytesLeft);
+    // Find first confirmed frame and get info
+    MP3Header::Frame frame;
+    long offset = MP3Header::findFrame(data, length, &frame);
     if (offset < 0) {
-        heap_caps_free(buffer);
         return false;
     }
     
-    readPtr += offset;
-    bytesLeft -= offset;
+    MP3Header::VbrInfo vbr;
+    MP3Header::parseVbr(data + offset, length - offset, frame, &vbr);
+    describe(frame, vbr, (streamSize > (size_t)offset) ? streamSize - offset : 0, info);
+    return true;
+}
+
+void MP3Decoder::describe(const MP3Header::Frame& frame, const MP3Header::VbrInfo& vbr, size_t audioBytes, MP3Info* info) {
+    info->sampleRate = frame.sampleRate;
+    info->channels = frame.channels;
+    info->bitRate = frame.bitRate;
+    info->valid = true;
     
-    MP3FrameInfo frameInfo;
-    int result = MP3GetNextFrameInfo(_decoder, &frameInfo, (unsigned char*)readPtr);
+    if (vbr.frames > 0) {
+        // The VBR header counts the frames, so the duration is exact
+        uint64_t samples = (uint64_t)vbr.frames * frame.samplesPerFrame;
+        uint32_t trim = vbr.hasLame ? (uint32_t)vbr.encoderDelay + vbr.encoderPadding : 0;
+        samples = (samples > trim) ? samples - trim : 0;
+        info->durationMs = (uint32_t)(samples * 1000 / frame.sampleRate);
+        if (vbr.bytes > 0 && info->durationMs > 0) {
+            info->bitRate = (int)((uint64_t)vbr.bytes * 8000 / info->durationMs);  // Average
+        }
+    } else {
+        // Estimate duration (rough calculation, exact for CBR)
+        info->durationMs = (uint32_t)((uint64_t)audioBytes * 8000 / frame.bitRate);
+    }
+    info->duration = info->durationMs / 1000;
+}
+
+bool MP3Decoder::buildIndex(fs::FS& fs, const String& filePath, uint32_t interval) {
+    FileByteSource file;
+    if (!file.open(fs, filePath)) {
+        _index.clear();
+        return false;
+    }
+    return _index.build(&file, interval);
+}
+
+bool MP3Decoder::buildIndex(ByteSource* source, uint32_t interval) {
+    return _index.build(source, interval);
+}
+
+bool MP3Decoder::loadIndex(fs::FS& fs, const String& indexPath, size_t streamSize) {
+    FileByteSource file;
+    if (!file.open(fs, indexPath)) {
+        _index.clear();
+        return false;
+    }
+    return _index.load(&file, streamSize);
+}
+
+bool MP3Decoder::saveIndex(fs::FS& fs, const String& indexPath) const {
+    size_t size = _index.serializedSize();
+    if (!_index.isValid()) {
+        return false;
+    }
     
-    heap_caps_free(buffer);
+    uint8_t* data = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
+    if (!data) {
+        return false;
+    }
+    _index.serialize(data, size);
     
-    if (result != 0) {
+    File file = fs.open(indexPath, "w");
+    bool result = file && file.write(data, size) == size;
+    if (file) {
+        file.close();
+    }
+    heap_caps_free(data);
+    return result;
+}
+
+bool MP3Decoder::prepareIndex(fs::FS& fs, const String& filePath, uint32_t interval) {
+    FileByteSource file;
+    if (!file.open(fs, filePath)) {
+        _index.clear();
         return false;
     }
     
-    info->sampleRate = frameInfo.samprate;
-    info->channels = frameInfo.nChans;
-    info->bitRate = frameInfo.bitrate;
-    info->valid = true;
+    String indexPath = filePath + ".idx";
+    if (loadIndex(fs, indexPath, file.size())) {
+        return true;
+    }
+    
+    if (!_index.build(&file, interval)) {
+        return false;
+    }
+    if (!saveIndex(fs, indexPath)) {
+        Serial.printf("MP3 index for %s not saved\n", filePath.c_str());
+    }
+    return true;
+}
 
-    // Print MP3 info for debugging
-    Serial.printf("MP3 Info: SampleRate=%d Hz, Channels=%d, BitRate=%d kbps\n", info->sampleRate, info->channels, info->bitRate);
+bool MP3Decoder::seekToMs(uint32_t ms) {
+    if (!_streaming || !_source->isSeekable() || !indexMatches()) {
+        return false;
+    }
+    
+    // Start one frame early where possible: decoding it primes the bit
+    // reservoir and the synthesis overlap for the target frame
+    uint32_t target = _index.msToFrame(ms);
+    uint32_t entryFrame;
+    size_t offset;
+    if (!_index.lookup(target > 0 ? target - 1 : 0, &entryFrame, &offset) || !_source->seek(offset)) {
+        return false;
+    }
+    
+    // Drop buffered data of the old position
+    _bytesLeft = 0;
+    _readPos = 0;
+    _frameState = STATE_SYNC;
+    _discardFrames = target - entryFrame;
+    
+    // Position on the audible timeline, as frameToMs() counts it
+    uint64_t start = (uint64_t)target * _index.getSamplesPerFrame();
+    uint32_t delay = _index.hasGaplessInfo() ? _index.getEncoderDelay() : 0;
+    _positionSamples = (start > delay) ? start - delay : 0;
+    _trimStart = 0;
+    if (_trimEnd) {
+        uint64_t total = _index.getTotalSamples();
+        _samplesLeft = (total > _positionSamples) ? total - _positionSamples : 0;
+    }
+    return true;
+}
+
+uint32_t MP3Decoder::getDurationMs() const {
+    if (indexMatches()) {
+        return _index.getDurationMs();
+    }
+    return _streamInfo.valid ? _streamInfo.durationMs : 0;
+}
+
+size_t MP3Decoder::getMemoryUsage() const {
+    size_t bytes = 0;
+    if (_inputBuffer) {
+        bytes += INPUT_BUFFER_SIZE;
+    }
+    if (_outputBuffer) {
+        bytes += OUTPUT_BUFFER_SIZE * sizeof(int16_t);
+    }
+    if (_streamBuffer) {
+        bytes += STREAM_BUFFER_SIZE + STREAM_MIRROR_SIZE;
+    }
+    return bytes + _index.getMemoryUsage();
+}
+
+uint32_t MP3Decoder::getElapsedMs() const {
+    if (!_streamInfo.valid || _streamInfo.sampleRate <= 0) {
+        return 0;
+    }
+    return (uint32_t)(_positionSamples * 1000 / _streamInfo.sampleRate);
+}
 
-    // Estimate duration (rough calculation)
-    if (frameInfo.bitrate > 0) {
-        info->duration = (fileSize * 8) / frameInfo.bitrate;
+bool MP3Decoder::getProgress(Progress* progress) const {
+    if (!progress || !_streamInfo.valid) {
+        return false;
+    }
+    
+    progress->elapsedMs = getElapsedMs();
+    progress->durationMs = getDurationMs();
+    
+    if (indexMatches() && progress->durationMs > 0) {
+        // Exact duration: progress follows time
+        progress->fraction = (float)progress->elapsedMs / progress->durationMs;
+    } else if (_audioBytes > 0) {
+        // Bytes consumed track time even for VBR streams without an index
+        progress->fraction = (float)consumedBytes() / _audioBytes;
+        if (progress->fraction > 0.0f) {
+            progress->durationMs = (uint32_t)(progress->elapsedMs / progress->fraction);
+        }
     } else {
-        info->duration = 0;
+        progress->fraction = 0.0f;  // Live stream of unknown length
     }
     
+    progress->fraction = constrain(progress->fraction, 0.0f, 1.0f);
+    progress->remainingMs = (progress->durationMs > progress->elapsedMs) ? progress->durationMs - progress->elapsedMs : 0;
     return true;
 }
 
+size_t MP3Decoder::consumedBytes() const {
+    if (!_streaming) {
+        return _consumedBytes;
+    }
+    size_t readOffset = _source->position() - _bytesLeft;
+    return (readOffset > _audioStart) ? readOffset - _audioStart : 0;
+}
+
+bool MP3Decoder::indexMatches() const {
+    if (!_index.isValid()) {
+        return false;
+    }
+    // Without a source the index is assumed to describe the next stream
+    return !_source || !_source->size() || _source->size() == _index.getStreamSize();
+}
+
 void MP3Decoder::freePCMBuffer(int16_t* pcmBuffer) {
     if (pcmBuffer) {
         heap_caps_free(pcmBuffer);
@@ -282,133 +574,349 @@ void MP3Decoder::freePCMBuffer(int16_t* pcmBuffer) {
 }
 
 bool MP3Decoder::startStreaming(const String& filePath, StreamCallback callback) {
+    return startStreaming(SPIFFS, filePath, callback);
+}
+
+bool MP3Decoder::startStreaming(fs::FS& fs, const String& filePath, StreamCallback callback) {
     if (!_initialized || _streaming) {
         return false;
     }
     
     // Open the file
-    _streamFile = SPIFFS.open(filePath, "r");
-    if (!_streamFile) {
+    if (!_fileSource.open(fs, filePath)) {
         return false;
     }
     
-    // Allocate streaming buffer
-    _streamBuffer = (uint8_t*)heap_caps_malloc(STREAM_BUFFER_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
-    if (!_streamBuffer) {
-        _streamFile.close();
+    if (!startStreaming(&_fileSource, callback)) {
+        _fileSource.close();
         return false;
     }
     
-    // Get file information
-    if (!getFileInfo(filePath, &_streamInfo)) {
-        heap_caps_free(_streamBuffer);
-        _streamFile.close();
+    return true;
+}
+
+bool MP3Decoder::startStreaming(ByteSource* source, StreamCallback callback) {
+    if (!_initialized || _streaming || !source) {
         return false;
     }
     
+    // The ring plus its mirrored tail is allocated once and kept for later streams
+    if (!_streamBuffer) {
+        _streamBuffer = (uint8_t*)heap_caps_malloc(STREAM_BUFFER_SIZE + STREAM_MIRROR_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
+        if (!_streamBuffer) {
+            return false;
+        }
+        _allocationCount++;
+    }
+    
     // Initialize streaming state
+    _source = source;
     _callback = callback;
     _bytesLeft = 0;
-    _readPtr = _streamBuffer;
+    _readPos = 0;
     _firstFrame = true;
+    _discardFrames = 0;
+    _streamStats = StreamStats();
+    _positionSamples = 0;
+    _consumedBytes = 0;
+    _audioBytes = 0;
+    _trimStart = 0;
+    _trimEnd = false;
+    _samplesLeft = 0;
+    _frameState = STATE_SYNC;
     _streaming = true;
     
-    // Fill the buffer with initial data
-    if (!fillStreamBuffer()) {
+    // Fill the buffer with initial data, then take the stream information
+    // from its first frame header instead of opening the stream twice.
+    // A live source may need a moment to deliver the first bytes.
+    bool filled = skipStreamTags();
+    while (filled && _bytesLeft < STREAM_BUFFER_SIZE && !source->isEnd()) {
+        if (fillStreamBuffer() == 0) {
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+    _audioStart = source->position() - _bytesLeft;
+    size_t streamSize = (source->size() > _audioStart) ? source->size() - _audioStart : 0;
+    _audioBytes = streamSize;
+    if (!filled || _bytesLeft == 0 ||
+        !parseInfo(_streamBuffer + _readPos, contiguousBytes(), streamSize, &_streamInfo)) {
         stopStreaming();
         return false;
     }
+    if (indexMatches()) {
+        _streamInfo.durationMs = _index.getDurationMs();
+        _streamInfo.duration = _streamInfo.durationMs / 1000;
+    }
+    if (_gapless) {
+        setupGapless();
+    }
     
     return true;
 }
 
-bool MP3Decoder::processStreamFrame() {
-    if (!_streaming || !_initialized) {
-        return false;
+void MP3Decoder::setupGapless() {
+    const uint8_t* data = _streamBuffer + _readPos;
+    size_t length = contiguousBytes();
+    MP3Header::Frame frame;
+    MP3Header::VbrInfo vbr;
+    long offset = MP3Header::findFrame(data, length, &frame);
+    if (offset < 0 || !MP3Header::parseVbr(data + offset, length - offset, frame, &vbr) ||
+        (size_t)offset + frame.frameSize > _bytesLeft) {
+        return;
     }
     
-    // Find the next MP3 frame sync word
-    int offset = MP3FindSyncWord((unsigned char*)_readPtr, _bytesLeft);
-    if (offset < 0) {
-        // No sync word found in current buffer, try to fill more data
-        if (!fillStreamBuffer()) {
-            return false; // End of file or error
+    // The header frame carries no audio
+    consume(offset + frame.frameSize);
+    
+    if (vbr.hasLame) {
+        _trimStart = vbr.encoderDelay + MP3Header::DECODER_DELAY;
+        if (vbr.frames > 0) {
+            uint64_t samples = (uint64_t)vbr.frames * frame.samplesPerFrame;
+            uint32_t trim = (uint32_t)vbr.encoderDelay + vbr.encoderPadding;
+            _samplesLeft = (samples > trim) ? samples - trim : 0;
+            _trimEnd = true;
         }
-        return processStreamFrame(); // Try again with new data
     }
-    
-    // Move to the sync word position
-    _readPtr += offset;
-    _bytesLeft -= offset;
-    
-    // Get frame info
-    MP3FrameInfo frameInfo;
-    int result = MP3GetNextFrameInfo(_decoder, &frameInfo, (unsigned char*)_readPtr);
-    if (result != 0) {
-        // Invalid frame, skip one byte and try again
-        _readPtr++;
-        _bytesLeft--;
-        if (_bytesLeft == 0) {
-            if (!fillStreamBuffer()) {
+}
+
+bool MP3Decoder::skipStreamTags() {
+    while (true) {
+        while (_bytesLeft < MP3Header::ID3V2_HEADER_SIZE && !_source->isEnd()) {
+            if (fillStreamBuffer() == 0) {
+                vTaskDelay(pdMS_TO_TICKS(1));
+            }
+        }
+        
+        size_t tagSize = MP3Header::id3v2Size(_streamBuffer + _readPos, contiguousBytes());
+        if (tagSize == 0) {
+            return true;
+        }
+        
+        // Drop the buffered part of the tag, then seek or read past the rest
+        size_t buffered = _min(tagSize, _bytesLeft);
+        consume(buffered);
+        size_t remaining = tagSize - buffered;
+        if (remaining == 0) {
+            continue;
+        }
+        _bytesLeft = 0;
+        _readPos = 0;
+        if (_source->isSeekable()) {
+            if (!_source->seek(_source->position() + remaining)) {
                 return false;
             }
+            continue;
+        }
+        while (remaining > 0) {
+            size_t bytesRead = _source->read(_streamBuffer, _min(remaining, STREAM_BUFFER_SIZE));
+            if (bytesRead == 0) {
+                if (_source->isEnd()) {
+                    return false;
+                }
+                vTaskDelay(pdMS_TO_TICKS(1));
+            }
+            remaining -= bytesRead;
         }
-        return processStreamFrame();
     }
-    
-    // Update stream info from first valid frame
-    if (_firstFrame) {
-        _streamInfo.sampleRate = frameInfo.samprate;
-        _streamInfo.channels = frameInfo.nChans;
-        _streamInfo.bitRate = frameInfo.bitrate;
-        _streamInfo.valid = true;
-        _firstFrame = false;
+}
+
+void MP3Decoder::setReadChunkSize(size_t bytes) {
+    // Whole chunks must tile the ring so reads stay block aligned
+    size_t chunk = 64;
+    while (chunk * 2 <= bytes && chunk * 2 <= STREAM_BUFFER_SIZE / 2) {
+        chunk *= 2;
     }
-    
-    // Decode the frame
-    int result2 = 0;
-    try {
-        result2 = MP3Decode(_decoder, (unsigned char**)&_readPtr, (int*)&_bytesLeft, _outputBuffer, 0);
-    } catch(...) {
-        result2 = -1;
+    _readChunk = chunk;
+}
+
+void MP3Decoder::setGapless(bool enabled) {
+    _gapless = enabled;
+}
+
+void MP3Decoder::resetStreamStats() {
+    _streamStats = StreamStats();
+}
+
+void MP3Decoder::setFrameBudget(size_t maxScanBytes, size_t maxFrames) {
+    _maxScanBytes = _max(maxScanBytes, (size_t)1);
+    _maxFrames = _max(maxFrames, (size_t)1);
+}
+
+MP3Decoder::StreamStatus MP3Decoder::decodeNextFrame() {
+    if (!_streaming || !_initialized) {
+        return STREAM_ERROR;
     }
     
-    if (result2 != 0) {
-        if (result2 == ERR_MP3_INDATA_UNDERFLOW) {
-            // Need more data
-            if (!fillStreamBuffer()) {
-                return false;
+    size_t scanned = 0;  // Bytes skipped without producing a frame
+    size_t frames = 0;
+    
+    while (frames < _maxFrames) {
+        if (scanned >= _maxScanBytes) {
+            return frames ? STREAM_FRAME : STREAM_BUDGET;
+        }
+        
+        uint8_t* data = _streamBuffer + _readPos;
+        size_t contiguous = contiguousBytes();
+        
+        switch (_frameState) {
+        case STATE_SYNC: {
+            int offset = MP3FindSyncWord((unsigned char*)data, contiguous);
+            if (offset < 0) {
+                // Drop the garbage but keep the last byte, it may start a sync word
+                size_t skip = (contiguous > 1) ? contiguous - 1 : 0;
+                consume(skip);
+                scanned += skip;
+                // Only refill once the buffered data has been searched entirely
+                _frameState = (_bytesLeft > 1) ? STATE_SYNC : STATE_FILL;
+                break;
             }
-            return processStreamFrame();
-        } else {
-            // Other error, skip this frame
-            _readPtr++;
-            _bytesLeft--;
-            if (_bytesLeft == 0) {
-                if (!fillStreamBuffer()) {
-                    return false;
+            consume(offset);
+            scanned += offset;
+            _frameState = STATE_HEADER;
+            break;
+        }
+        
+        case STATE_HEADER: {
+            // The header is four bytes; wait for the rest at the buffer end
+            if (_bytesLeft < 4) {
+                _frameState = STATE_FILL;
+                break;
+            }
+            MP3FrameInfo frameInfo;
+            if (MP3GetNextFrameInfo(_decoder, &frameInfo, (unsigned char*)data) != 0) {
+                // False sync, skip one byte and search again
+                consume(1);
+                scanned++;
+                _frameState = STATE_SYNC;
+                break;
+            }
+            
+            // Update stream info from first valid frame
+            if (_firstFrame) {
+                _streamInfo.sampleRate = frameInfo.samprate;
+                _streamInfo.channels = frameInfo.nChans;
+                _streamInfo.bitRate = frameInfo.bitrate;
+                _streamInfo.valid = true;
+                _firstFrame = false;
+            }
+            _frameState = STATE_DECODE;
+            break;
+        }
+        
+        case STATE_DECODE: {
+            // The mirror keeps every frame up to STREAM_MIRROR_SIZE contiguous
+            unsigned char* readPtr = data;
+            int bytesLeft = (int)contiguous;
+            int result = 0;
+            try {
+                result = MP3Decode(_decoder, &readPtr, &bytesLeft, _outputBuffer, 0);
+            } catch(...) {
+                result = -1;
+            }
+            size_t consumed = readPtr - data;
+            
+            if (result == ERR_MP3_INDATA_UNDERFLOW && contiguous < STREAM_MIRROR_SIZE) {
+                // Frame continues past the buffered data, decode it again after a refill
+                _frameState = STATE_FILL;
+                break;
+            }
+            
+            _frameState = STATE_SYNC;
+            if (result == ERR_MP3_MAINDATA_UNDERFLOW) {
+                // Bit reservoir not primed yet (stream started mid-way), the
+                // decoder consumed the frame without output
+                consume(consumed);
+                scanned += consumed;
+                if (_discardFrames > 0) {
+                    _discardFrames--;
+                }
+                break;
+            }
+            if (result != 0) {
+                // Other error, or a frame larger than any valid one: skip one byte
+                consume(1);
+                scanned++;
+                break;
+            }
+            
+            // Successfully decoded a frame
+            consume(consumed);
+            MP3FrameInfo frameInfo;
+            MP3GetLastFrameInfo(_decoder, &frameInfo);
+            frames++;
+            _streamStats.frames++;
+            _streamStats.samplesDecoded += frameInfo.outputSamps;
+            if (_discardFrames > 0) {
+                // Still before the seek target
+                _discardFrames--;
+            } else {
+                // Drop encoder delay and padding (gapless mode)
+                const int16_t* pcm = _outputBuffer;
+                size_t channels = _max(frameInfo.nChans, 1);
+                size_t samples = frameInfo.outputSamps / channels;
+                if (_trimStart > 0) {
+                    size_t skip = _min((size_t)_trimStart, samples);
+                    _trimStart -= skip;
+                    samples -= skip;
+                    pcm += skip * channels;
+                }
+                if (_trimEnd) {
+                    samples = (size_t)_min((uint64_t)samples, _samplesLeft);
+                    _samplesLeft -= samples;
                 }
+                
+                _positionSamples += samples;
+                if (samples > 0 && _callback && !_callback(pcm, samples * channels, _streamInfo)) {
+                    // Callback returned false, stop streaming
+                    stopStreaming();
+                    return STREAM_STOPPED;
+                }
+            }
+            
+            // Top up once half the ring is free, so reads stay large
+            if (_bytesLeft <= STREAM_BUFFER_SIZE / 2) {
+                fillStreamBuffer();
+            }
+            break;
+        }
+        
+        case STATE_FILL: {
+            if (_bytesLeft == STREAM_BUFFER_SIZE) {
+                // A full buffer holds no complete frame, treat it as garbage
+                consume(1);
+                scanned++;
+                _frameState = STATE_SYNC;
+                break;
+            }
+            if (fillStreamBuffer() > 0) {
+                _frameState = STATE_SYNC;
+                break;
+            }
+            if (frames) {
+                return STREAM_FRAME;
             }
-            return processStreamFrame();
+            return _source->isEnd() ? STREAM_END : STREAM_NEED_DATA;
+        }
         }
     }
     
-    // Successfully decoded a frame
-    if (_callback) {
-        // Call the callback with the decoded data
-        if (!_callback(_outputBuffer, frameInfo.outputSamps, _streamInfo)) {
-            // Callback returned false, stop streaming
-            stopStreaming();
+    return STREAM_FRAME;
+}
+
+bool MP3Decoder::processStreamFrame() {
+    while (true) {
+        switch (decodeNextFrame()) {
+        case STREAM_FRAME:
+            return true;
+        case STREAM_NEED_DATA:
+            vTaskDelay(pdMS_TO_TICKS(1));
+            break;
+        case STREAM_BUDGET:
+            break;
+        default:
             return false;
         }
     }
-    
-    // If we're running low on data, fill the buffer
-    if (_bytesLeft < INPUT_BUFFER_SIZE && _streamFile.available()) {
-        fillStreamBuffer();
-    }
-    
-    return true;
 }
 
 void MP3Decoder::stopStreaming() {
@@ -416,43 +924,66 @@ void MP3Decoder::stopStreaming() {
         return;
     }
     
+    // Keep the final position for getProgress()
+    _consumedBytes = consumedBytes();
+    
     _streaming = false;
     
-    if (_streamFile) {
-        _streamFile.close();
-    }
-    
-    if (_streamBuffer) {
-        heap_caps_free(_streamBuffer);
-        _streamBuffer = nullptr;
+    // Only the file source is owned; other sources belong to the caller
+    if (_source == &_fileSource) {
+        _fileSource.close();
     }
+    _source = nullptr;
     
     _bytesLeft = 0;
-    _readPtr = nullptr;
+    _readPos = 0;
     _callback = nullptr;
 }
 
-bool MP3Decoder::fillStreamBuffer() {
-    // If no file or end of file, return false
-    if (!_streamFile || !_streamFile.available()) {
-        return false;
+size_t MP3Decoder::fillStreamBuffer() {
+    // If no source or end of stream, there is nothing to add
+    if (!_source || _source->isEnd()) {
+        return 0;
     }
     
-    // If we have bytes left, move them to the beginning of the buffer
-    if (_bytesLeft > 0 && _readPtr != _streamBuffer) {
-        memmove(_streamBuffer, _readPtr, _bytesLeft);
+    // Read into the free space up to the ring end, in whole chunks when possible
+    size_t writePos = (_readPos + _bytesLeft) & (STREAM_BUFFER_SIZE - 1);
+    size_t length = _min(STREAM_BUFFER_SIZE - _bytesLeft, STREAM_BUFFER_SIZE - writePos);
+    if (length > _readChunk) {
+        length -= length % _readChunk;
+    }
+    if (length == 0) {
+        return 0;
     }
     
-    _readPtr = _streamBuffer;
-    
-    // Fill the rest of the buffer
-    size_t spaceLeft = STREAM_BUFFER_SIZE - _bytesLeft;
-    size_t bytesRead = _streamFile.read(_streamBuffer + _bytesLeft, spaceLeft);
-    
+    // A live source (ring) may return nothing yet
+    size_t bytesRead = _source->read(_streamBuffer + writePos, length);
     if (bytesRead == 0) {
-        return false; // No more data
+        return 0;
+    }
+    
+    // Bytes landing at the ring start are mirrored behind its end, so a
+    // frame that wraps can still be decoded in place
+    if (writePos < STREAM_MIRROR_SIZE) {
+        size_t mirrored = _min(bytesRead, STREAM_MIRROR_SIZE - writePos);
+        memcpy(_streamBuffer + STREAM_BUFFER_SIZE + writePos, _streamBuffer + writePos, mirrored);
+        _streamStats.bytesMoved += mirrored;
     }
     
     _bytesLeft += bytesRead;
-    return true;
+    _streamStats.refills++;
+    _streamStats.bytesRead += bytesRead;
+    return bytesRead;
+}
+
+size_t MP3Decoder::contiguousBytes() const {
+    return _min(_bytesLeft, STREAM_BUFFER_SIZE + STREAM_MIRROR_SIZE - _readPos);
+}
+
+void MP3Decoder::consume(size_t bytes) {
+    _readPos += bytes;
+    if (_readPos >= STREAM_BUFFER_SIZE) {
+        _readPos -= STREAM_BUFFER_SIZE;  // Continue from the copy at the ring start
+    }
+    _bytesLeft -= bytes;
 }
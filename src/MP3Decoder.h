@@ -3,6 +3,9 @@
 #include <Arduino.h>
 #include <SPIFFS.h>
 #include <functional>
+#include "ByteSource.h"
+#include "FileByteSource.h"
+#include "MP3FrameIndex.h"
 
 // Include the ESP32 Helix MP3 decoder library
 extern "C" {
@@ -15,7 +18,9 @@ extern "C" {
  * Uses the ESP32 Helix MP3 decoder library to decode MP3 files
  * and convert them to PCM data for playback through speakers.
  * 
- * Supports both full decoding and streaming decoding modes.
+ * Supports both full decoding and streaming decoding modes. Encoded data
+ * comes from any ByteSource; the path-based functions open files through
+ * the Arduino FS API (SPIFFS by default).
  */
 class MP3Decoder {
 public:
@@ -24,9 +29,49 @@ public:
         int channels;
         int bitRate;
         int duration;      // in seconds
+        uint32_t durationMs; // exact with a frame index, else estimated from the bit rate
         bool valid;
     };
 
+    /**
+     * Why decodeNextFrame() returned
+     */
+    enum StreamStatus {
+        STREAM_FRAME,      // At least one frame was decoded and passed to the callback
+        STREAM_NEED_DATA,  // The source has no data yet (live source), call again later
+        STREAM_BUDGET,     // Scan budget used up while resyncing, call again
+        STREAM_END,        // End of stream, no complete frame left
+        STREAM_STOPPED,    // The callback asked to stop, streaming has been stopped
+        STREAM_ERROR       // Not streaming or not initialized
+    };
+
+    static const size_t DEFAULT_MAX_SCAN_BYTES = 8192; // Bytes skipped per call before returning
+    static const size_t DEFAULT_MAX_FRAMES = 1;        // Frames decoded per call
+    static const size_t DEFAULT_READ_CHUNK = 512;      // Source read granularity (SD sector)
+
+    /**
+     * Input buffering counters of the current stream, reset by startStreaming()
+     */
+    struct StreamStats {
+        uint32_t refills;         // Source reads that returned data
+        uint32_t bytesRead;       // Encoded bytes read from the source
+        uint32_t bytesMoved;      // Bytes copied inside the stream buffer (mirrored tail)
+        uint32_t frames;          // Frames decoded
+        uint32_t samplesDecoded;  // PCM samples decoded (all channels)
+
+        StreamStats() : refills(0), bytesRead(0), bytesMoved(0), frames(0), samplesDecoded(0) {}
+    };
+
+    /**
+     * Playback position of the current or last stream
+     */
+    struct Progress {
+        float fraction;        // 0.0 to 1.0
+        uint32_t elapsedMs;    // From decoded samples
+        uint32_t remainingMs;
+        uint32_t durationMs;   // Exact with a frame index, else extrapolated from bytes consumed
+    };
+
     // Callback for streaming data
     using StreamCallback = std::function<bool(const int16_t* data, size_t len, MP3Info& info)>;
 
@@ -49,6 +94,27 @@ public:
      */
     bool decodeFile(const String& filePath, int16_t** pcmBuffer, size_t* pcmSize, MP3Info* info = nullptr);
 
+    /**
+     * Decode MP3 file from any filesystem
+     * @param fs Filesystem holding the file (SPIFFS, LittleFS, SD, ...)
+     * @param filePath Path to MP3 file
+     * @param pcmBuffer Output buffer for PCM data (will be allocated)
+     * @param pcmSize Output size of PCM data
+     * @param info Output MP3 file information
+     * @return true if decoding was successful
+     */
+    bool decodeFile(fs::FS& fs, const String& filePath, int16_t** pcmBuffer, size_t* pcmSize, MP3Info* info = nullptr);
+
+    /**
+     * Decode a whole MP3 stream from a byte source
+     * @param source Source to read until its end
+     * @param pcmBuffer Output buffer for PCM data (will be allocated)
+     * @param pcmSize Output size of PCM data
+     * @param info Output MP3 file information
+     * @return true if decoding was successful
+     */
+    bool decodeSource(ByteSource* source, int16_t** pcmBuffer, size_t* pcmSize, MP3Info* info = nullptr);
+
     /**
      * Decode MP3 data from memory
      * @param mp3Data Input MP3 data
@@ -68,11 +134,112 @@ public:
      */
     bool startStreaming(const String& filePath, StreamCallback callback);
 
+    /**
+     * Start streaming decoding of a file on any filesystem
+     * @param fs Filesystem holding the file (SPIFFS, LittleFS, SD, ...)
+     * @param filePath Path to MP3 file
+     * @param callback Callback function to receive PCM data
+     * @return true if successfully started streaming
+     */
+    bool startStreaming(fs::FS& fs, const String& filePath, StreamCallback callback);
+
+    /**
+     * Start streaming decoding from a byte source
+     * 
+     * Stream information is taken from the first frame header in the data,
+     * so the source is read only once and need not be seekable.
+     * 
+     * @param source Source of encoded data (not owned, must stay valid until stopStreaming())
+     * @param callback Callback function to receive PCM data
+     * @return true if successfully started streaming
+     */
+    bool startStreaming(ByteSource* source, StreamCallback callback);
+
+    /**
+     * Decode the next frames in streaming mode
+     * 
+     * Runs the frame state machine (sync, header, decode, refill) until the
+     * per-call budget is used up or it has to wait. Garbage and bad frames
+     * are skipped without recursion, and at most the scan budget of bytes
+     * is skipped per call, so both stack use and time per call are bounded.
+     * Never blocks on the source.
+     * 
+     * @return Why the call returned
+     */
+    StreamStatus decodeNextFrame();
+
     /**
      * Process next frame in streaming mode
+     * 
+     * Blocking wrapper around decodeNextFrame() that waits for data and
+     * continues through budget stops until one frame is decoded.
+     * 
      * @return true if a frame was processed, false if end of stream or error
      */
     bool processStreamFrame();
+
+    /**
+     * Set the per-call budget of decodeNextFrame()
+     * @param maxScanBytes Bytes skipped while resyncing before returning STREAM_BUDGET (at least 1)
+     * @param maxFrames Frames decoded before returning STREAM_FRAME (at least 1)
+     */
+    void setFrameBudget(size_t maxScanBytes, size_t maxFrames = DEFAULT_MAX_FRAMES);
+
+    /**
+     * Set the granularity of source reads
+     * 
+     * Reads are issued in whole chunks at chunk-aligned buffer offsets;
+     * match the filesystem block (512 for SD, 4096 for LittleFS).
+     * 
+     * @param bytes Chunk size, rounded down to a power of two (64 to 4096)
+     */
+    void setReadChunkSize(size_t bytes);
+
+    /**
+     * Trim encoder delay and padding for gapless playback
+     * 
+     * Applies to streams started afterwards. The Xing/Info header frame is
+     * skipped (it decodes to silence). With a LAME header, the encoder delay
+     * plus the synthesis filter delay is dropped from the start, and the
+     * output ends after the exact sample count of the header, so
+     * consecutive tracks join without a gap. Other streams play untrimmed.
+     * 
+     * @param enabled true to trim (default false)
+     */
+    void setGapless(bool enabled);
+
+    /**
+     * Get input buffering counters of the current or last stream
+     * 
+     * Divide by samplesDecoded / (sampleRate * channels) for per-second rates.
+     * 
+     * @return Stream statistics
+     */
+    const StreamStats& getStreamStats() const { return _streamStats; }
+
+    /**
+     * Reset input buffering counters
+     */
+    void resetStreamStats();
+
+    /**
+     * Get the heap memory held by this decoder
+     *
+     * Counts the input, output and stream buffers and the frame index. The
+     * stream buffer is allocated by the first stream and kept for the next.
+     *
+     * @return Bytes allocated, excluding the Helix decoder's internal state
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * Get the number of buffers allocated for decoding
+     *
+     * Counts the decoder instance and the input, output and stream buffers.
+     *
+     * @return Allocations since construction
+     */
+    size_t getAllocationCount() const { return _allocationCount; }
     
     /**
      * Stop streaming and clean up resources
@@ -84,6 +251,12 @@ public:
      * @return true if streaming is in progress
      */
     bool isStreaming() const { return _streaming; }
+
+    /**
+     * Get information about the stream being decoded
+     * @return Stream information (updated from the first decoded frame)
+     */
+    const MP3Info& getStreamInfo() const { return _streamInfo; }
     
     /**
      * Get MP3 file information without full decoding
@@ -93,6 +266,131 @@ public:
      */
     bool getFileInfo(const String& filePath, MP3Info* info);
 
+    /**
+     * Get MP3 file information from any filesystem
+     * @param fs Filesystem holding the file (SPIFFS, LittleFS, SD, ...)
+     * @param filePath Path to MP3 file
+     * @param info Output MP3 information
+     * @return true if information was retrieved successfully
+     */
+    bool getFileInfo(fs::FS& fs, const String& filePath, MP3Info* info);
+
+    /**
+     * Get MP3 information from the current position of a byte source
+     * 
+     * ID3v2 tags are skipped by their size (seeking past them when the
+     * source allows), sync is confirmed by two consecutive frame headers
+     * and the duration comes from a Xing/VBRI header when there is one.
+     * Reads a few hundred bytes into a stack buffer, no heap is used.
+     * Consumes the bytes it reads; seekable sources are rewound afterwards.
+     * 
+     * @param source Source of encoded data
+     * @param info Output MP3 information
+     * @return true if information was retrieved successfully
+     */
+    bool getFileInfo(ByteSource* source, MP3Info* info);
+
+    /**
+     * Build the frame index of a file
+     * 
+     * Scans the frame headers once without decoding. The index enables
+     * seekToMs() and an exact duration while that file is streamed.
+     * 
+     * @param fs Filesystem holding the file
+     * @param filePath Path to MP3 file
+     * @param interval Frames between index entries
+     * @return true if the index was built
+     */
+    bool buildIndex(fs::FS& fs, const String& filePath, uint32_t interval = MP3FrameIndex::DEFAULT_INTERVAL);
+
+    /**
+     * Build the frame index from a byte source
+     * 
+     * Reads the source to its end (seekable sources are rewound first), so
+     * do not call it on a source that is being streamed.
+     * 
+     * @param source Source of encoded data
+     * @param interval Frames between index entries
+     * @return true if the index was built
+     */
+    bool buildIndex(ByteSource* source, uint32_t interval = MP3FrameIndex::DEFAULT_INTERVAL);
+
+    /**
+     * Load a frame index from a sidecar file
+     * @param fs Filesystem holding the index file
+     * @param indexPath Path to the index file
+     * @param streamSize Size of the MP3 file the index must match, 0 to skip the check
+     * @return true if the index was loaded
+     */
+    bool loadIndex(fs::FS& fs, const String& indexPath, size_t streamSize = 0);
+
+    /**
+     * Save the frame index to a sidecar file
+     * @param fs Filesystem to write to
+     * @param indexPath Path to the index file
+     * @return true if the index was written
+     */
+    bool saveIndex(fs::FS& fs, const String& indexPath) const;
+
+    /**
+     * Load the index of a file from its sidecar (filePath + ".idx"), or
+     * build it and write the sidecar when it is missing or stale
+     * @param fs Filesystem holding the file
+     * @param filePath Path to MP3 file
+     * @param interval Frames between index entries when building
+     * @return true if an index for the file is available
+     */
+    bool prepareIndex(fs::FS& fs, const String& filePath, uint32_t interval = MP3FrameIndex::DEFAULT_INTERVAL);
+
+    /**
+     * Drop the frame index
+     */
+    void clearIndex() { _index.clear(); }
+
+    /**
+     * Get the frame index
+     * @return Index, invalid if none was built or loaded
+     */
+    const MP3FrameIndex& getIndex() const { return _index; }
+
+    /**
+     * Move the stream to a time position
+     * 
+     * Needs a seekable source and the frame index of the same stream. The
+     * source is moved to the closest indexed frame before the target and the
+     * frames up to the target are decoded and discarded, so the first frame
+     * passed to the callback is the one containing the target.
+     * 
+     * @param ms Position in milliseconds from the start of the audio
+     * @return true if the stream was moved
+     */
+    bool seekToMs(uint32_t ms);
+
+    /**
+     * Get the position of the current or last stream
+     * 
+     * Elapsed time counts decoded samples. With a frame index the fraction
+     * follows time exactly; otherwise it is the share of the stream bytes
+     * consumed, which also holds for VBR files, and the duration is
+     * extrapolated from it. Valid after stopStreaming() for the last stream.
+     * 
+     * @param progress Output progress
+     * @return false if nothing has been streamed yet
+     */
+    bool getProgress(Progress* progress) const;
+
+    /**
+     * Get the time decoded so far
+     * @return Milliseconds of PCM decoded (from the seek target after seekToMs())
+     */
+    uint32_t getElapsedMs() const;
+
+    /**
+     * Get the duration of the stream
+     * @return Exact duration with a frame index, else the bit rate estimate, in milliseconds
+     */
+    uint32_t getDurationMs() const;
+
     /**
      * Free PCM buffer allocated by decode functions
      * @param pcmBuffer Buffer to free
@@ -112,18 +410,83 @@ private:
     
     static const size_t INPUT_BUFFER_SIZE = 2048;
     static const size_t OUTPUT_BUFFER_SIZE = 4608; // Max PCM samples per frame
-    static const size_t STREAM_BUFFER_SIZE = 8192; // Size of streaming buffer
+    static const size_t STREAM_BUFFER_SIZE = 8192; // Size of the streaming ring, must be a power of two
+    static const size_t STREAM_MIRROR_SIZE = 2048; // Ring start mirrored past its end, covers the largest frame
     
     uint8_t* _inputBuffer;
     int16_t* _outputBuffer;
-    uint8_t* _streamBuffer;     // Buffer for streaming data
-    File _streamFile;           // File handle for streaming
+    uint8_t* _streamBuffer;     // Ring for streaming data, followed by the mirrored tail
+    size_t _allocationCount;    // Buffers allocated by init() and startStreaming()
+    ByteSource* _source;        // Source being streamed
+    FileByteSource _fileSource; // Owned source for path-based streaming
     size_t _bytesLeft;          // Bytes left in the streaming buffer
-    uint8_t* _readPtr;          // Current read position in streaming buffer
+    size_t _readPos;            // Current read offset in the ring
+    size_t _readChunk;          // Source read granularity
+    StreamStats _streamStats;   // Input buffering counters
+    MP3FrameIndex _index;       // Seek index of the streamed file
+    uint32_t _discardFrames;    // Frames to decode silently after a seek
+    uint64_t _positionSamples;  // Samples per channel decoded, from the start or seek target
+    size_t _audioStart;         // Stream offset of the audio, after tags
+    size_t _audioBytes;         // Stream bytes from the audio start, 0 if unknown
+    size_t _consumedBytes;      // Bytes consumed when streaming stopped
+    bool _gapless;              // Trim the next streams, see setGapless()
+    uint32_t _trimStart;        // Samples per channel still to drop at the start
+    bool _trimEnd;              // The sample count of the stream is known
+    uint64_t _samplesLeft;      // Samples per channel still to deliver when _trimEnd is set
     bool _firstFrame;           // Flag for first frame processing
+    size_t _maxScanBytes;       // Per-call budget of skipped bytes
+    size_t _maxFrames;          // Per-call budget of decoded frames
+    
+    enum FrameState {
+        STATE_SYNC,    // Looking for a sync word
+        STATE_HEADER,  // Validating the frame header at the read pointer
+        STATE_DECODE,  // Decoding the frame at the read pointer
+        STATE_FILL     // Refilling the stream buffer from the source
+    };
+    FrameState _frameState;
     MP3Info _streamInfo;        // MP3 info for streaming
     StreamCallback _callback;   // Callback for streaming data
     
     bool decodeInternal(const uint8_t* mp3Data, size_t mp3Size, int16_t** pcmBuffer, size_t* pcmSize, MP3Info* info);
-    bool fillStreamBuffer();    // Fill the streaming buffer with more data
+    size_t fillStreamBuffer();  // Read more data without waiting, returns bytes added
+    size_t contiguousBytes() const; // Buffered bytes readable in place from the read offset
+    void consume(size_t bytes);     // Advance the read offset
+    bool indexMatches() const;      // The index describes the current stream
+    size_t consumedBytes() const;   // Audio bytes decoded so far
+
+    static const size_t INFO_PROBE_SIZE = 256;  // Covers a frame header and its Xing/LAME header
+    static const uint32_t READ_STALL_LIMIT = 1000; // Empty reads in a row, 1 ms apart, before a source is given up on
+
+    static size_t readFully(ByteSource* source, uint8_t* buffer, size_t length);  // Bytes read before the end or a stall
+    static bool skipTo(ByteSource* source, size_t position, uint8_t* scratch, size_t scratchSize);
+
+    /**
+     * Parse stream information from the first confirmed frame header in a buffer
+     * @param data Encoded bytes, after any ID3v2 tag
+     * @param length Number of bytes
+     * @param streamSize Bytes from data to the stream end for the duration estimate, 0 if unknown
+     * @param info Output MP3 information
+     * @return true if a frame header was found
+     */
+    static bool parseInfo(const uint8_t* data, size_t length, size_t streamSize, MP3Info* info);
+
+    /**
+     * Fill stream information from a frame header and optional VBR header
+     * @param frame First frame header
+     * @param vbr VBR header of that frame (type VBR_NONE if absent)
+     * @param audioBytes Bytes from the first frame to the stream end, 0 if unknown
+     * @param info Output MP3 information
+     */
+    static void describe(const MP3Header::Frame& frame, const MP3Header::VbrInfo& vbr, size_t audioBytes, MP3Info* info);
+
+    /**
+     * Skip ID3v2 tags at the start of the streaming buffer
+     * @return false if the stream ended inside a tag
+     */
+    bool skipStreamTags();
+
+    /**
+     * Skip the Xing/Info frame at the read offset and set up trimming from its LAME header
+     */
+    void setupGapless();
 };
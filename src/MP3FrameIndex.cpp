@@ -0,0 +1,381 @@
+#include "MP3FrameIndex.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+/**
+ * Sequential window over a source for header scanning
+ */
+class ScanReader {
+public:
+    ScanReader(ByteSource* source, uint8_t* buffer, size_t capacity)
+        : _source(source), _buffer(buffer), _capacity(capacity), _start(source->position()), _length(0) {}
+
+    /**
+     * Make bytes [position, position + count) available
+     *
+     * @return false if the stream ends before them
+     */
+    bool fill(size_t position, size_t count) {
+        if (position >= _start && position + count <= _start + _length) {
+            return true;
+        }
+        if (count > _capacity || position < _start) {
+            return false;  // Larger than the window, or behind it
+        }
+
+        if (position < _start + _length) {
+            // Keep the tail that is still needed; it is short while scanning
+            size_t keep = _start + _length - position;
+            memmove(_buffer, _buffer + (position - _start), keep);
+            _length = keep;
+        } else {
+            // Jump over the rest of a frame
+            size_t skip = position - (_start + _length);
+            if (skip > 0 && !skipBytes(skip)) {
+                return false;
+            }
+            _length = 0;
+        }
+        _start = position;
+
+        while (_length < count) {
+            size_t bytesRead = _source->read(_buffer + _length, _capacity - _length);
+            if (bytesRead == 0) {
+                return false;
+            }
+            _length += bytesRead;
+        }
+        return true;
+    }
+
+    const uint8_t* at(size_t position) const { return _buffer + (position - _start); }
+
+    /**
+     * Bytes buffered from a position on
+     */
+    size_t buffered(size_t position) const {
+        return (position >= _start && position < _start + _length) ? _start + _length - position : 0;
+    }
+
+private:
+    ByteSource* _source;
+    uint8_t* _buffer;
+    size_t _capacity;
+    size_t _start;   // Stream position of _buffer[0]
+    size_t _length;
+
+    bool skipBytes(size_t count) {
+        if (_source->isSeekable()) {
+            return _source->seek(_source->position() + count);
+        }
+        while (count > 0) {
+            size_t n = (count < _capacity) ? count : _capacity;
+            size_t bytesRead = _source->read(_buffer, n);
+            if (bytesRead == 0) {
+                return false;
+            }
+            count -= bytesRead;
+        }
+        return true;
+    }
+};
+
+/**
+ * Check for a frame header at a position that is followed by a matching one
+ */
+bool validFrameAt(ScanReader& reader, size_t position, MP3Header::Frame* frame) {
+    if (!reader.fill(position, MP3Header::HEADER_SIZE) || !MP3Header::parseFrame(reader.at(position), frame)) {
+        return false;
+    }
+
+    // Load both headers at once, the window cannot move back
+    MP3Header::Frame next;
+    size_t nextPosition = position + frame->frameSize;
+    if (!reader.fill(position, frame->frameSize + MP3Header::HEADER_SIZE)) {
+        return reader.buffered(position) >= frame->frameSize;  // Last frame of the stream
+    }
+    return MP3Header::parseFrame(reader.at(nextPosition), &next) && MP3Header::matches(*frame, next);
+}
+
+/**
+ * Search for the next validated frame header
+ *
+ * @return Position of the frame, or SIZE_MAX if none within MAX_SYNC_SEARCH
+ */
+size_t findFrame(ScanReader& reader, size_t position, MP3Header::Frame* frame) {
+    size_t limit = position + MP3FrameIndex::MAX_SYNC_SEARCH;
+    while (position < limit) {
+        if (!reader.fill(position, MP3Header::HEADER_SIZE)) {
+            return SIZE_MAX;
+        }
+        if (*reader.at(position) == 0xFF && validFrameAt(reader, position, frame)) {
+            return position;
+        }
+        position++;
+    }
+    return SIZE_MAX;
+}
+
+void put16(uint8_t* p, uint16_t value) {
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+void put32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+uint16_t get16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t get32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+}
+
+MP3FrameIndex::MP3FrameIndex()
+    : _entries(nullptr), _entryCount(0), _entryCapacity(0), _interval(DEFAULT_INTERVAL),
+      _streamSize(0), _audioStart(0), _frameCount(0), _sampleRate(0), _samplesPerFrame(0),
+      _channels(0), _gapless(false), _encoderDelay(0), _encoderPadding(0) {
+}
+
+MP3FrameIndex::~MP3FrameIndex() {
+    free(_entries);
+}
+
+void MP3FrameIndex::clear() {
+    _entryCount = 0;
+    _streamSize = 0;
+    _audioStart = 0;
+    _frameCount = 0;
+    _sampleRate = 0;
+    _samplesPerFrame = 0;
+    _channels = 0;
+    _gapless = false;
+    _encoderDelay = 0;
+    _encoderPadding = 0;
+}
+
+bool MP3FrameIndex::build(ByteSource* source, uint32_t interval) {
+    clear();
+    if (!source || interval == 0) {
+        return false;
+    }
+    if (source->isSeekable() && source->position() != 0) {
+        source->seek(0);
+    }
+    _interval = interval;
+
+    uint8_t* buffer = (uint8_t*)malloc(SCAN_BUFFER_SIZE);
+    if (!buffer) {
+        return false;
+    }
+    ScanReader reader(source, buffer, SCAN_BUFFER_SIZE);
+
+    // Skip ID3v2 tags by their size instead of searching through them
+    size_t position = source->position();
+    while (reader.fill(position, MP3Header::ID3V2_HEADER_SIZE)) {
+        size_t tagSize = MP3Header::id3v2Size(reader.at(position), MP3Header::ID3V2_HEADER_SIZE);
+        if (tagSize == 0) {
+            break;
+        }
+        position += tagSize;
+    }
+
+    MP3Header::Frame first;
+    position = findFrame(reader, position, &first);
+    if (position == SIZE_MAX) {
+        free(buffer);
+        return false;
+    }
+    _sampleRate = first.sampleRate;
+    _channels = first.channels;
+    _samplesPerFrame = first.samplesPerFrame;
+
+    // A Xing/Info/VBRI frame carries no audio
+    size_t probe = (first.frameSize < MP3Header::VBR_PROBE_SIZE) ? first.frameSize : MP3Header::VBR_PROBE_SIZE;
+    MP3Header::VbrInfo vbr;
+    reader.fill(position, probe);
+    if (MP3Header::parseVbr(reader.at(position), reader.buffered(position), first, &vbr)) {
+        position += first.frameSize;
+        if (vbr.hasLame) {
+            _gapless = true;
+            _encoderDelay = vbr.encoderDelay;
+            _encoderPadding = vbr.encoderPadding;
+        }
+    }
+    _audioStart = position;
+
+    MP3Header::Frame frame;
+    while (reader.fill(position, MP3Header::HEADER_SIZE)) {
+        if (!MP3Header::parseFrame(reader.at(position), &frame) || !MP3Header::matches(frame, first)) {
+            // Garbage or a trailing tag: resync, or stop at the end
+            position = findFrame(reader, position + 1, &frame);
+            if (position == SIZE_MAX) {
+                break;
+            }
+        }
+
+        // A truncated last frame is not counted
+        if (!reader.fill(position + frame.frameSize - 1, 1)) {
+            break;
+        }
+
+        if (_frameCount % _interval == 0 && !append((uint32_t)position)) {
+            clear();
+            free(buffer);
+            return false;
+        }
+        _frameCount++;
+        position += frame.frameSize;
+    }
+
+    free(buffer);
+    _streamSize = source->size() ? source->size() : position;
+    return _frameCount > 0;
+}
+
+uint64_t MP3FrameIndex::getTotalSamples() const {
+    uint64_t samples = (uint64_t)_frameCount * _samplesPerFrame;
+    uint32_t trim = _gapless ? (uint32_t)_encoderDelay + _encoderPadding : 0;
+    return (samples > trim) ? samples - trim : 0;
+}
+
+uint32_t MP3FrameIndex::getDurationMs() const {
+    if (_sampleRate == 0) {
+        return 0;
+    }
+    return (uint32_t)(getTotalSamples() * 1000 / _sampleRate);
+}
+
+uint32_t MP3FrameIndex::msToFrame(uint32_t ms) const {
+    if (_frameCount == 0 || _samplesPerFrame == 0) {
+        return 0;
+    }
+    uint64_t sample = (uint64_t)ms * _sampleRate / 1000 + (_gapless ? _encoderDelay : 0);
+    uint64_t frame = sample / _samplesPerFrame;
+    return (frame < _frameCount) ? (uint32_t)frame : _frameCount - 1;
+}
+
+uint32_t MP3FrameIndex::frameToMs(uint32_t frame) const {
+    if (_sampleRate == 0) {
+        return 0;
+    }
+    uint64_t sample = (uint64_t)frame * _samplesPerFrame;
+    uint32_t delay = _gapless ? _encoderDelay : 0;
+    sample = (sample > delay) ? sample - delay : 0;
+    return (uint32_t)(sample * 1000 / _sampleRate);
+}
+
+bool MP3FrameIndex::lookup(uint32_t frame, uint32_t* entryFrame, size_t* offset) const {
+    if (!isValid() || !entryFrame || !offset) {
+        return false;
+    }
+    uint32_t entry = frame / _interval;
+    if (entry >= _entryCount) {
+        entry = _entryCount - 1;
+    }
+    *entryFrame = entry * _interval;
+    *offset = _entries[entry];
+    return true;
+}
+
+size_t MP3FrameIndex::serializedSize() const {
+    return FILE_HEADER_SIZE + (size_t)_entryCount * sizeof(uint32_t);
+}
+
+size_t MP3FrameIndex::serialize(uint8_t* buffer, size_t capacity) const {
+    size_t size = serializedSize();
+    if (!isValid() || !buffer || capacity < size) {
+        return 0;
+    }
+
+    put32(buffer, FILE_MAGIC);
+    put32(buffer + 4, (uint32_t)_streamSize);
+    put32(buffer + 8, (uint32_t)_audioStart);
+    put32(buffer + 12, _frameCount);
+    put32(buffer + 16, _sampleRate);
+    put16(buffer + 20, _samplesPerFrame);
+    buffer[22] = _channels;
+    buffer[23] = _gapless ? 1 : 0;
+    put16(buffer + 24, _encoderDelay);
+    put16(buffer + 26, _encoderPadding);
+    put32(buffer + 28, _interval);
+    put32(buffer + 32, _entryCount);
+    for (uint32_t i = 0; i < _entryCount; i++) {
+        put32(buffer + FILE_HEADER_SIZE + i * sizeof(uint32_t), _entries[i]);
+    }
+    return size;
+}
+
+bool MP3FrameIndex::load(ByteSource* source, size_t streamSize) {
+    clear();
+    if (!source) {
+        return false;
+    }
+
+    uint8_t header[FILE_HEADER_SIZE];
+    if (source->read(header, sizeof(header)) != sizeof(header) || get32(header) != FILE_MAGIC) {
+        return false;
+    }
+
+    uint32_t size = get32(header + 4);
+    uint32_t frameCount = get32(header + 12);
+    uint32_t interval = get32(header + 28);
+    uint32_t entryCount = get32(header + 32);
+
+    // A stale index (file replaced) or a damaged one is rejected
+    if ((streamSize && size != streamSize) || interval == 0 || frameCount == 0 ||
+        entryCount != (frameCount + interval - 1) / interval || !reserve(entryCount)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < entryCount; i++) {
+        uint8_t entry[sizeof(uint32_t)];
+        if (source->read(entry, sizeof(entry)) != sizeof(entry)) {
+            _entryCount = 0;
+            return false;
+        }
+        _entries[i] = get32(entry);
+        _entryCount = i + 1;
+    }
+
+    _streamSize = size;
+    _audioStart = get32(header + 8);
+    _frameCount = frameCount;
+    _sampleRate = get32(header + 16);
+    _samplesPerFrame = get16(header + 20);
+    _channels = header[22];
+    _gapless = header[23] != 0;
+    _encoderDelay = get16(header + 24);
+    _encoderPadding = get16(header + 26);
+    _interval = interval;
+    return true;
+}
+
+bool MP3FrameIndex::reserve(uint32_t count) {
+    if (count <= _entryCapacity) {
+        return true;
+    }
+    uint32_t* entries = (uint32_t*)realloc(_entries, count * sizeof(uint32_t));
+    if (!entries) {
+        return false;
+    }
+    _entries = entries;
+    _entryCapacity = count;
+    return true;
+}
+
+bool MP3FrameIndex::append(uint32_t offset) {
+    if (_entryCount == _entryCapacity && !reserve(_entryCapacity ? _entryCapacity * 2 : 64)) {
+        return false;
+    }
+    _entries[_entryCount++] = offset;
+    return true;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ByteSource.h"
+#include "MP3Header.h"
+
+/**
+ * Seek index of an MP3 stream
+ *
+ * build() walks the frame headers once without decoding, skipping an
+ * ID3v2 tag and the Xing/Info/VBRI header frame, and records the byte
+ * offset of every interval-th audio frame. The exact frame count gives an
+ * exact duration for VBR files too; encoder delay and padding from a LAME
+ * header are taken off it.
+ *
+ * The index can be serialized to a small sidecar file and loaded back, so
+ * the scan is done once per file.
+ */
+class MP3FrameIndex {
+public:
+    static const uint32_t DEFAULT_INTERVAL = 32;        // Frames per entry (~0.8 s at 44.1 kHz)
+    static const uint32_t FILE_MAGIC = 0x3149504D;      // "MPI1" little-endian
+    static const size_t FILE_HEADER_SIZE = 36;
+    static const size_t SCAN_BUFFER_SIZE = 4096;
+    static const size_t MAX_SYNC_SEARCH = 65536;        // Bytes searched for the first or next frame
+
+    MP3FrameIndex();
+    ~MP3FrameIndex();
+
+    /**
+     * Build the index by scanning a stream
+     *
+     * Reads the source to its end; seekable sources are rewound to the start
+     * first. Offsets are absolute positions in the source.
+     *
+     * @param source Source of encoded data
+     * @param interval Frames between index entries
+     * @return true if at least one frame was found
+     */
+    bool build(ByteSource* source, uint32_t interval = DEFAULT_INTERVAL);
+
+    /**
+     * Drop the index
+     */
+    void clear();
+
+    bool isValid() const { return _entryCount > 0; }
+
+    size_t getStreamSize() const { return _streamSize; }
+    size_t getAudioStart() const { return _audioStart; }         // First audio frame, after tags and VBR header
+    uint32_t getFrameCount() const { return _frameCount; }        // Audio frames, VBR header frame excluded
+    uint32_t getSampleRate() const { return _sampleRate; }
+    uint8_t getChannels() const { return _channels; }
+    uint16_t getSamplesPerFrame() const { return _samplesPerFrame; }
+    uint32_t getInterval() const { return _interval; }
+    bool hasGaplessInfo() const { return _gapless; }             // Delay/padding come from a LAME header
+    uint16_t getEncoderDelay() const { return _encoderDelay; }
+    uint16_t getEncoderPadding() const { return _encoderPadding; }
+    size_t getMemoryUsage() const { return _entryCapacity * sizeof(uint32_t); }  // Heap bytes held by the entries
+
+    /**
+     * Get the number of audible samples per channel
+     *
+     * @return Decoded samples minus encoder delay and padding
+     */
+    uint64_t getTotalSamples() const;
+
+    /**
+     * Get the exact duration
+     *
+     * @return Duration in milliseconds, 0 without an index
+     */
+    uint32_t getDurationMs() const;
+
+    /**
+     * Convert a time to the audio frame that contains it
+     *
+     * @param ms Time from the start of the audible signal
+     * @return Frame number, clamped to the last frame
+     */
+    uint32_t msToFrame(uint32_t ms) const;
+
+    /**
+     * Convert a frame number to the time at its start
+     *
+     * @param frame Frame number
+     * @return Time in milliseconds
+     */
+    uint32_t frameToMs(uint32_t frame) const;
+
+    /**
+     * Find the closest indexed frame at or before a frame
+     *
+     * @param frame Target frame number
+     * @param entryFrame Output frame number of the entry
+     * @param offset Output byte offset of the entry
+     * @return true if the index is valid
+     */
+    bool lookup(uint32_t frame, uint32_t* entryFrame, size_t* offset) const;
+
+    /**
+     * Get the size of the serialized index
+     *
+     * @return Bytes written by serialize()
+     */
+    size_t serializedSize() const;
+
+    /**
+     * Serialize the index for a sidecar file
+     *
+     * @param buffer Destination
+     * @param capacity Destination size, at least serializedSize()
+     * @return Bytes written, 0 if the index is invalid or the buffer too small
+     */
+    size_t serialize(uint8_t* buffer, size_t capacity) const;
+
+    /**
+     * Load a serialized index
+     *
+     * @param source Sidecar data
+     * @param streamSize Size of the stream the index must belong to, 0 to skip the check
+     * @return true if the index was loaded
+     */
+    bool load(ByteSource* source, size_t streamSize = 0);
+
+private:
+    uint32_t* _entries;
+    uint32_t _entryCount;
+    uint32_t _entryCapacity;
+    uint32_t _interval;
+    size_t _streamSize;
+    size_t _audioStart;
+    uint32_t _frameCount;
+    uint32_t _sampleRate;
+    uint16_t _samplesPerFrame;
+    uint8_t _channels;
+    bool _gapless;
+    uint16_t _encoderDelay;
+    uint16_t _encoderPadding;
+
+    bool reserve(uint32_t count);
+    bool append(uint32_t offset);
+};
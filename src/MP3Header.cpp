@@ -0,0 +1,161 @@
+#include "MP3Header.h"
+#include <string.h>
+
+// Bit rates in kbps by [MPEG-1 / MPEG-2 and 2.5][layer - 1][index]
+static const uint16_t BIT_RATES[2][3][15] = {
+    {
+        {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},
+        {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},
+        {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320}
+    },
+    {
+        {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},
+        {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},
+        {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}
+    }
+};
+
+// Sample rates in Hz by [version][index]
+static const uint32_t SAMPLE_RATES[3][3] = {
+    {44100, 48000, 32000},
+    {22050, 24000, 16000},
+    {11025, 12000, 8000}
+};
+
+static uint32_t readBE32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+bool MP3Header::parseFrame(const uint8_t* data, Frame* frame) {
+    if (!data || !frame || data[0] != 0xFF || (data[1] & 0xE0) != 0xE0) {
+        return false;
+    }
+
+    uint8_t versionBits = (data[1] >> 3) & 0x03;
+    uint8_t layerBits = (data[1] >> 1) & 0x03;
+    uint8_t bitRateIndex = data[2] >> 4;
+    uint8_t sampleRateIndex = (data[2] >> 2) & 0x03;
+
+    // Reserved version, layer, rates and emphasis; free format has no frame size
+    if (versionBits == 1 || layerBits == 0 || bitRateIndex == 0 || bitRateIndex == 15 ||
+        sampleRateIndex == 3 || (data[3] & 0x03) == 2) {
+        return false;
+    }
+
+    frame->version = (versionBits == 3) ? MPEG_1 : (versionBits == 2) ? MPEG_2 : MPEG_2_5;
+    frame->layer = 4 - layerBits;
+    frame->hasCrc = (data[1] & 0x01) == 0;
+    frame->channelMode = data[3] >> 6;
+    frame->channels = (frame->channelMode == 3) ? 1 : 2;
+    frame->bitRate = BIT_RATES[frame->version == MPEG_1 ? 0 : 1][frame->layer - 1][bitRateIndex] * 1000;
+    frame->sampleRate = SAMPLE_RATES[frame->version][sampleRateIndex];
+
+    uint32_t padding = (data[2] >> 1) & 0x01;
+    if (frame->layer == 1) {
+        frame->samplesPerFrame = 384;
+        frame->frameSize = (12 * frame->bitRate / frame->sampleRate + padding) * 4;
+    } else {
+        frame->samplesPerFrame = (frame->layer == 3 && frame->version != MPEG_1) ? 576 : 1152;
+        frame->frameSize = frame->samplesPerFrame / 8 * frame->bitRate / frame->sampleRate + padding;
+    }
+    return true;
+}
+
+bool MP3Header::matches(const Frame& a, const Frame& b) {
+    return a.version == b.version && a.layer == b.layer && a.sampleRate == b.sampleRate;
+}
+
+long MP3Header::findFrame(const uint8_t* data, size_t length, Frame* frame) {
+    if (!data || !frame) {
+        return -1;
+    }
+
+    for (size_t offset = 0; offset + HEADER_SIZE <= length; offset++) {
+        if (data[offset] != 0xFF || !parseFrame(data + offset, frame)) {
+            continue;
+        }
+
+        // A sync pattern inside audio data is rarely followed by a valid header
+        size_t next = offset + frame->frameSize;
+        Frame nextFrame;
+        if (next + HEADER_SIZE > length || (parseFrame(data + next, &nextFrame) && matches(*frame, nextFrame))) {
+            return (long)offset;
+        }
+    }
+    return -1;
+}
+
+size_t MP3Header::id3v2Size(const uint8_t* data, size_t length) {
+    if (!data || length < ID3V2_HEADER_SIZE || memcmp(data, "ID3", 3) != 0) {
+        return 0;
+    }
+
+    // The size is a 28-bit synchsafe integer (7 bits per byte)
+    const uint8_t* size = data + 6;
+    if ((size[0] | size[1] | size[2] | size[3]) & 0x80) {
+        return 0;
+    }
+    size_t tagSize = ((size_t)size[0] << 21) | ((size_t)size[1] << 14) | ((size_t)size[2] << 7) | size[3];
+
+    bool hasFooter = (data[5] & 0x10) != 0;
+    return ID3V2_HEADER_SIZE + tagSize + (hasFooter ? ID3V2_HEADER_SIZE : 0);
+}
+
+bool MP3Header::parseVbr(const uint8_t* data, size_t length, const Frame& frame, VbrInfo* vbr) {
+    if (!data || !vbr || frame.layer != 3) {
+        return false;
+    }
+    *vbr = VbrInfo();
+
+    // The Xing header follows the side information
+    size_t xing;
+    if (frame.version == MPEG_1) {
+        xing = HEADER_SIZE + ((frame.channels == 1) ? 17 : 32);
+    } else {
+        xing = HEADER_SIZE + ((frame.channels == 1) ? 9 : 17);
+    }
+
+    if (xing + 8 <= length && (memcmp(data + xing, "Xing", 4) == 0 || memcmp(data + xing, "Info", 4) == 0)) {
+        vbr->type = VbrInfo::VBR_XING;
+        uint32_t flags = readBE32(data + xing + 4);
+        size_t pos = xing + 8;
+
+        if ((flags & 0x01) && pos + 4 <= length) {
+            vbr->frames = readBE32(data + pos);
+            pos += 4;
+        }
+        if ((flags & 0x02) && pos + 4 <= length) {
+            vbr->bytes = readBE32(data + pos);
+            pos += 4;
+        }
+        if ((flags & 0x04) && pos + 100 <= length) {
+            memcpy(vbr->toc, data + pos, sizeof(vbr->toc));
+            vbr->hasToc = true;
+            pos += 100;
+        }
+        if (flags & 0x08) {
+            pos += 4;  // Quality indicator
+        }
+
+        // LAME extension: 9-byte encoder string, then delay/padding at offset 21
+        if (pos + 24 <= length && (memcmp(data + pos, "LAME", 4) == 0 || memcmp(data + pos, "Lavc", 4) == 0 ||
+                                   memcmp(data + pos, "Lavf", 4) == 0)) {
+            const uint8_t* delay = data + pos + 21;
+            vbr->encoderDelay = (uint16_t)((delay[0] << 4) | (delay[1] >> 4));
+            vbr->encoderPadding = (uint16_t)(((delay[1] & 0x0F) << 8) | delay[2]);
+            vbr->hasLame = true;
+        }
+        return true;
+    }
+
+    // The VBRI header is always 32 bytes after the frame header
+    size_t vbri = HEADER_SIZE + 32;
+    if (vbri + 18 <= length && memcmp(data + vbri, "VBRI", 4) == 0) {
+        vbr->type = VbrInfo::VBR_VBRI;
+        vbr->bytes = readBE32(data + vbri + 10);
+        vbr->frames = readBE32(data + vbri + 14);
+        return true;
+    }
+
+    return false;
+}
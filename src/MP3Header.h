@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * MPEG audio frame header and tag parsing
+ *
+ * Reads frame headers, ID3v2 tag sizes and the Xing/Info, LAME and VBRI
+ * headers found in the first frame of VBR files, without decoding audio.
+ */
+class MP3Header {
+public:
+    static const size_t HEADER_SIZE = 4;
+    static const size_t ID3V2_HEADER_SIZE = 10;
+    static const size_t MAX_FRAME_SIZE = 2881;         // MPEG-2.5 layer 2 at 160 kbps and 8 kHz
+    static const size_t MAX_LAYER3_FRAME_SIZE = 1441;  // MPEG-1 layer 3 at 320 kbps and 32 kHz
+    static const size_t VBR_PROBE_SIZE = 192;          // Bytes of the first frame needed by parseVbr()
+    static const uint16_t DECODER_DELAY = 529;         // Samples added by the layer 3 synthesis filter
+
+    enum Version {
+        MPEG_1,
+        MPEG_2,
+        MPEG_2_5
+    };
+
+    /**
+     * Decoded frame header
+     */
+    struct Frame {
+        Version version;
+        uint8_t layer;             // 1, 2 or 3
+        uint32_t bitRate;          // bits per second
+        uint32_t sampleRate;       // Hz
+        uint8_t channels;          // 1 or 2
+        uint8_t channelMode;       // 0 stereo, 1 joint, 2 dual, 3 mono
+        bool hasCrc;
+        uint16_t samplesPerFrame;  // Per channel
+        uint16_t frameSize;        // Bytes including the header
+    };
+
+    /**
+     * VBR header found in the first frame
+     */
+    struct VbrInfo {
+        enum Type {
+            VBR_NONE,
+            VBR_XING,   // "Xing" (VBR) or "Info" (CBR) header
+            VBR_VBRI    // Fraunhofer VBRI header
+        };
+
+        Type type;
+        uint32_t frames;           // Audio frames after the header frame, 0 if unknown
+        uint32_t bytes;            // Audio bytes including the header frame, 0 if unknown
+        bool hasToc;
+        uint8_t toc[100];          // Xing seek table: byte position in 1/256 per percent of time
+        bool hasLame;              // LAME (or libavcodec) extension with encoder delay/padding
+        uint16_t encoderDelay;     // Samples of encoder delay at the start
+        uint16_t encoderPadding;   // Samples of padding at the end
+
+        VbrInfo() : type(VBR_NONE), frames(0), bytes(0), hasToc(false), toc(),
+                    hasLame(false), encoderDelay(0), encoderPadding(0) {}
+    };
+
+    /**
+     * Parse a frame header
+     *
+     * Free-format and reserved values are rejected.
+     *
+     * @param data At least HEADER_SIZE bytes
+     * @param frame Output header
+     * @return true if the bytes are a valid frame header
+     */
+    static bool parseFrame(const uint8_t* data, Frame* frame);
+
+    /**
+     * Check if two headers belong to the same stream
+     *
+     * @return true if version, layer and sample rate agree
+     */
+    static bool matches(const Frame& a, const Frame& b);
+
+    /**
+     * Find the first frame header confirmed by the header that follows it
+     *
+     * A candidate whose following header lies beyond the buffer is returned
+     * unconfirmed; the caller checks that header separately.
+     *
+     * @param data Encoded bytes
+     * @param length Number of bytes
+     * @param frame Output header of the frame found
+     * @return Offset of the frame, -1 if none was found
+     */
+    static long findFrame(const uint8_t* data, size_t length, Frame* frame);
+
+    /**
+     * Get the size of an ID3v2 tag
+     *
+     * @param data Start of the stream
+     * @param length Bytes available (at least ID3V2_HEADER_SIZE for a result)
+     * @return Tag size including header and footer, 0 if there is no tag
+     */
+    static size_t id3v2Size(const uint8_t* data, size_t length);
+
+    /**
+     * Parse a Xing/Info (with LAME extension) or VBRI header
+     *
+     * @param data Start of the first frame
+     * @param length Bytes available from the frame start
+     * @param frame Header of that frame
+     * @param vbr Output VBR information
+     * @return true if a VBR header was found
+     */
+    static bool parseVbr(const uint8_t* data, size_t length, const Frame& frame, VbrInfo* vbr);
+};
@@ -1,16 +1,36 @@
 #pragma once
 
-#include "I2SSpeaker.h"
-#include "MP3Decoder.h"
+#include "MP3StreamPlayer.h"
 
 /**
  * MP3Player class that combines MP3 decoding with I2S output streaming
  * 
  * This class provides a simple interface for playing MP3 files using
  * streaming decode + streaming I2S output for memory efficiency.
+ *
+ * It is a static interface to one default MP3StreamPlayer; create
+ * MP3StreamPlayer instances directly to play several streams at once.
+ *
+ * Playback is either blocking (playFile / playFileWithProgress) or
+ * asynchronous (play), where a decoder task and a writer task are
+ * decoupled by a lock-free PCM ring buffer.
+ *
+ * Streams whose sample rate or channel count differ from the speaker are
+ * adapted before output, see FormatPolicy.
+ *
+ * With a mixer attached (setMixer), asynchronous playback becomes a mixer
+ * voice fed from the PCM ring, so other sounds can play on top of it.
  */
 class MP3Player {
 public:
+    static constexpr float MAX_VOLUME = MP3StreamPlayer::MAX_VOLUME;
+    static const uint32_t DEFAULT_PROGRESS_INTERVAL_MS = MP3StreamPlayer::DEFAULT_PROGRESS_INTERVAL_MS;
+
+    using ProgressCallback = MP3StreamPlayer::ProgressCallback;
+    using FormatPolicy = MP3StreamPlayer::FormatPolicy;
+    static constexpr FormatPolicy FORMAT_CONVERT = MP3StreamPlayer::FORMAT_CONVERT;
+    static constexpr FormatPolicy FORMAT_RECONFIGURE_SPEAKER = MP3StreamPlayer::FORMAT_RECONFIGURE_SPEAKER;
+
     /**
      * Initialize MP3 player with I2S speaker
      * 
@@ -22,22 +42,82 @@ public:
      * Play MP3 file with streaming (memory efficient)
      * 
      * @param filePath Path to MP3 file in SPIFFS
-     * @param volume Volume level (0.0 to 1.0)
+     * @param volume Volume level (0.0 to 2.0)
      * @return true if playback started successfully
      */
     static bool playFile(const String& filePath, float volume = 0.7f);
 
+    /**
+     * Play MP3 file from any filesystem with streaming
+     * 
+     * @param fs Filesystem holding the file (SPIFFS, LittleFS, SD, ...)
+     * @param filePath Path to MP3 file
+     * @param volume Volume level (0.0 to 2.0)
+     * @return true if playback completed successfully
+     */
+    static bool playFile(fs::FS& fs, const String& filePath, float volume = 0.7f);
+
     /**
      * Play MP3 file with streaming and progress callback
      * 
      * @param filePath Path to MP3 file
-     * @param volume Volume level (0.0 to 1.0)
-     * @param progressCallback Callback for playback progress
+     * @param volume Volume level (0.0 to 2.0)
+     * @param progressCallback Callback for playback progress (0.0 to 1.0)
      * @return true if playback completed successfully
      */
     static bool playFileWithProgress(const String& filePath, float volume = 0.7f,
                                    std::function<void(float)> progressCallback = nullptr);
 
+    /**
+     * Play MP3 file from any filesystem with position and time reports
+     * 
+     * The callback runs on the decoding task every progress interval and
+     * once more at the end of the file (fraction 1.0 when it played to the
+     * end). Build or load a frame index first (MP3Decoder::prepareIndex)
+     * for exact VBR durations.
+     * 
+     * @param fs Filesystem holding the file (SPIFFS, LittleFS, SD, ...)
+     * @param filePath Path to MP3 file
+     * @param volume Volume level (0.0 to 2.0)
+     * @param progressCallback Callback for playback progress
+     * @return true if playback completed successfully
+     */
+    static bool playFileWithProgress(fs::FS& fs, const String& filePath, float volume,
+                                   ProgressCallback progressCallback);
+
+    /**
+     * Start asynchronous MP3 playback and return immediately
+     * 
+     * A decoder task fills a PCM ring buffer while a writer task drains it
+     * into the speaker, so decode jitter (slow reads, resync) is absorbed
+     * by the ring instead of causing underruns. Use isPlaying() to poll
+     * for completion and stop() to abort.
+     * 
+     * @param filePath Path to MP3 file in SPIFFS
+     * @param volume Volume level (0.0 to 2.0)
+     * @return true if playback tasks were started
+     */
+    static bool play(const String& filePath, float volume = 0.7f);
+
+    /**
+     * Start asynchronous playback of a file on any filesystem
+     * 
+     * @param fs Filesystem holding the file (SPIFFS, LittleFS, SD, ...)
+     * @param filePath Path to MP3 file
+     * @param volume Volume level (0.0 to 2.0)
+     * @return true if playback tasks were started
+     */
+    static bool play(fs::FS& fs, const String& filePath, float volume = 0.7f);
+
+    /**
+     * Start asynchronous playback from a byte source (memory, network ring, ...)
+     * 
+     * @param source Source of encoded data (not owned, must stay valid until playback ends)
+     * @param volume Volume level (0.0 to 2.0)
+     * @return true if playback tasks were started
+     */
+    static bool play(ByteSource* source, float volume = 0.7f);
+
     /**
      * Stop current playback
      */
@@ -50,10 +130,31 @@ public:
      */
     static bool isPlaying();
 
+    /**
+     * Get the position of the current or last playback
+     * 
+     * Can be polled during asynchronous playback. Elapsed time counts
+     * decoded samples, so it runs ahead of the output by the PCM buffered
+     * in between.
+     * 
+     * @param progress Output progress
+     * @return false if nothing has been played yet
+     */
+    static bool getProgress(MP3Decoder::Progress* progress);
+
+    /**
+     * Set how often progress callbacks are made
+     * 
+     * @param intervalMs Minimum time between reports, 0 to report every frame
+     */
+    static void setProgressInterval(uint32_t intervalMs);
+
     /**
      * Set volume during playback
      * 
-     * @param volume Volume level (0.0 to 1.0)
+     * The change is ramped over a few milliseconds to avoid clicks.
+     * 
+     * @param volume Volume level (0.0 to 2.0, above 1.0 amplifies with saturation)
      */
     static void setVolume(float volume);
 
@@ -73,33 +174,133 @@ public:
      */
     static bool getFileInfo(const String& filePath, MP3Decoder::MP3Info* info);
 
-private:
-    static I2SSpeaker* _speaker;
-    static MP3Decoder _decoder;
-    static bool _initialized;
-    static bool _playing;
-    static float _volume;
-    static std::function<void(float)> _progressCallback;
-    static size_t _totalFrames;
-    static size_t _processedFrames;
+    /**
+     * Get number of heap allocations made by the player's playback path
+     * 
+     * Counts the decoder, converter, prefetch and PCM ring buffers, see
+     * MP3StreamPlayer::getAllocationCount(). Steady-state playback renders
+     * into pre-sized buffers, so this count must not grow while a file is
+     * playing.
+     * 
+     * @return Allocation count since init() or the last reset
+     */
+    static size_t getAllocationCount();
+
+    /**
+     * Reset the allocation counter
+     */
+    static void resetAllocationCount();
 
     /**
-     * Internal streaming callback for MP3 decoder
+     * Set how streams in a different format than the speaker are played
+     * 
+     * FORMAT_RECONFIGURE_SPEAKER plays the stream bit-exact but leaves the
+     * speaker in the stream's format afterwards; other producers sharing the
+     * speaker must not be writing when playback starts.
      * 
-     * @param data PCM audio data
-     * @param sampleCount Number of samples
-     * @param info MP3 stream information
-     * @return true to continue streaming, false to stop
+     * @param policy Format policy (default FORMAT_CONVERT)
      */
-    static bool streamingCallback(const int16_t* data, size_t sampleCount, 
-                                MP3Decoder::MP3Info& info);
+    static void setFormatPolicy(FormatPolicy policy);
 
     /**
-     * Apply volume to PCM samples
+     * Get the current format policy
      * 
-     * @param samples Input/output sample buffer
-     * @param sampleCount Number of samples
-     * @param volume Volume multiplier (0.0 to 1.0)
+     * @return Format policy
      */
-    static void applyVolume(int16_t* samples, size_t sampleCount, float volume);
+    static FormatPolicy getFormatPolicy();
+
+    /**
+     * Set resampler quality used when the stream rate differs from the speaker
+     * 
+     * Takes effect from the next playback.
+     * 
+     * @param quality Resampler quality (default QUALITY_MEDIUM)
+     */
+    static void setResamplerQuality(Resampler::Quality quality);
+
+    /**
+     * Play through a mixer instead of writing to the speaker directly
+     * 
+     * The decoded stream becomes a mixer voice and the volume its voice
+     * gain. The blocking play functions wait on the asynchronous path in
+     * this mode. The speaker format is never changed while a mixer is set.
+     * Takes effect from the next playback.
+     * 
+     * @param mixer Running mixer that owns the speaker, nullptr to write directly again
+     * @param priority Voice priority (ducked below higher-priority voices)
+     */
+    static void setMixer(AudioMixer* mixer, uint8_t priority = AudioMixer::PRIORITY_BACKGROUND);
+
+    /**
+     * Read files ahead on a separate task
+     * 
+     * Path-based playback then reads the file through a PrefetchByteSource,
+     * so the decoder only copies from memory and slow flash or SD reads are
+     * absorbed by the read-ahead. Takes effect from the next playback.
+     * 
+     * @param depth Blocks to read ahead (2 = double buffer), 0 to read directly
+     * @param blockSize Bytes per file read
+     */
+    static void setPrefetch(size_t depth, size_t blockSize = PrefetchByteSource::DEFAULT_BLOCK_SIZE);
+
+    /**
+     * Get prefetch hit/miss counters of the current or last file
+     * 
+     * @return Prefetch statistics
+     */
+    static PrefetchByteSource::Stats getPrefetchStats();
+
+    /**
+     * Add a file to the play queue, see MP3StreamPlayer::enqueue()
+     * 
+     * @param fs Filesystem holding the file (SPIFFS, LittleFS, SD, ...)
+     * @param filePath Path to MP3 file
+     * @return false if the player is not initialized or the queue is full
+     */
+    static bool enqueue(fs::FS& fs, const String& filePath);
+
+    /**
+     * Add a file in SPIFFS to the play queue
+     * 
+     * @param filePath Path to MP3 file in SPIFFS
+     * @return false if the player is not initialized or the queue is full
+     */
+    static bool enqueue(const String& filePath);
+
+    /**
+     * Start gapless asynchronous playback of the queued files
+     * 
+     * @param volume Volume level (0.0 to 2.0)
+     * @return true if a queued file started playing
+     */
+    static bool playQueue(float volume = 0.7f);
+
+    /**
+     * Remove all files from the play queue
+     */
+    static void clearQueue();
+
+    /**
+     * Get the number of queued files
+     * 
+     * @return Files waiting to be played
+     */
+    static size_t getQueueLength();
+
+    /**
+     * Trim encoder delay and padding between tracks (default true)
+     * 
+     * @param enabled true to trim
+     */
+    static void setGapless(bool enabled);
+
+    /**
+     * Get the player instance behind the static interface
+     * 
+     * @return Default player
+     */
+    static MP3StreamPlayer& getDefaultPlayer();
+
+private:
+    static MP3StreamPlayer _player;
 };
@@ -0,0 +1,814 @@
+#include "MP3StreamPlayer.h"
+#include <cstring>
+#include <esp_heap_caps.h>
+
+constexpr float MP3StreamPlayer::MAX_VOLUME;
+
+MP3StreamPlayer::MP3StreamPlayer()
+    : _speaker(nullptr), _initialized(false), _playing(false), _volume(0.7f),
+      _progressCallback(nullptr), _progressIntervalMs(DEFAULT_PROGRESS_INTERVAL_MS), _lastProgressMs(0),
+      _progress(), _hasProgress(false), _allocationCount(0), _allocationBase(0), _formatPolicy(FORMAT_CONVERT),
+      _resamplerQuality(Resampler::QUALITY_MEDIUM), _currentFile(0), _source(nullptr), _prefetchDepth(0),
+      _prefetchBlockSize(PrefetchByteSource::DEFAULT_BLOCK_SIZE), _mixer(nullptr),
+      _mixerPriority(AudioMixer::PRIORITY_BACKGROUND), _mixerVoice(-1), _queueHead(0), _queueCount(0),
+      _queueLock(nullptr), _pcmRingStorage(nullptr), _decodeTask(nullptr), _writerTask(nullptr),
+      _decodeStopped(nullptr), _writerStopped(nullptr), _decodeStarted(false), _writerStarted(false),
+      _decodeDone(false) {
+    _decoder.setGapless(true);
+}
+
+MP3StreamPlayer::~MP3StreamPlayer() {
+    stop();
+
+    if (_pcmRingStorage) {
+        heap_caps_free(_pcmRingStorage);
+    }
+
+    if (_queueLock) {
+        vSemaphoreDelete(_queueLock);
+    }
+
+    if (_decodeStopped) {
+        vSemaphoreDelete(_decodeStopped);
+    }
+
+    if (_writerStopped) {
+        vSemaphoreDelete(_writerStopped);
+    }
+}
+
+bool MP3StreamPlayer::init(I2SSpeaker* speaker) {
+    if (!speaker || !speaker->isInitialized()) {
+        return false;
+    }
+
+    _speaker = speaker;
+    
+    if (!_decoder.init()) {
+        return false;
+    }
+
+    if (!_queueLock) {
+        _queueLock = xSemaphoreCreateMutex();
+        if (!_queueLock) {
+            return false;
+        }
+    }
+
+    if (!_decodeStopped) {
+        _decodeStopped = xSemaphoreCreateBinary();
+    }
+    if (!_writerStopped) {
+        _writerStopped = xSemaphoreCreateBinary();
+    }
+    if (!_decodeStopped || !_writerStopped) {
+        return false;
+    }
+
+    _initialized = true;
+    _playing = false;
+    resetAllocationCount();
+    return true;
+}
+
+bool MP3StreamPlayer::playFile(const String& filePath, float volume) {
+    return playFileWithProgress(filePath, volume, nullptr);
+}
+
+bool MP3StreamPlayer::playFile(fs::FS& fs, const String& filePath, float volume) {
+    if (!_initialized || !_speaker || _playing || _decodeTask || _writerTask) {
+        return false;
+    }
+
+    ByteSource* source = openFile(fs, filePath);
+    if (!source) {
+        return false;
+    }
+    return playBlocking(source, volume, nullptr);
+}
+
+bool MP3StreamPlayer::playFileWithProgress(const String& filePath, float volume, 
+                                   std::function<void(float)> progressCallback) {
+    ProgressCallback callback = nullptr;
+    if (progressCallback) {
+        callback = [progressCallback](const MP3Decoder::Progress& progress) {
+            progressCallback(progress.fraction);
+        };
+    }
+    return playFileWithProgress(SPIFFS, filePath, volume, callback);
+}
+
+bool MP3StreamPlayer::playFileWithProgress(fs::FS& fs, const String& filePath, float volume,
+                                   ProgressCallback progressCallback) {
+    if (!_initialized || !_speaker || _playing || _decodeTask || _writerTask) {
+        return false;
+    }
+
+    ByteSource* source = openFile(fs, filePath);
+    if (!source) {
+        return false;
+    }
+    return playBlocking(source, volume, progressCallback);
+}
+
+bool MP3StreamPlayer::playBlocking(ByteSource* source, float volume, ProgressCallback progressCallback) {
+    // The mixer owns the speaker: decode on the task path and wait for it;
+    // the decoder task makes the progress reports
+    if (_mixer) {
+        _progressCallback = progressCallback;
+        if (!play(source, volume)) {
+            _progressCallback = nullptr;
+            closeFile();
+            return false;
+        }
+        while (_playing) {
+            vTaskDelay(pdMS_TO_TICKS(VOICE_POLL_MS));
+        }
+        _progressCallback = nullptr;
+        return true;
+    }
+
+    // Set volume and progress callback
+    _volume = constrain(volume, 0.0f, MAX_VOLUME);
+    _gain.resetGain(_volume);
+    _progressCallback = progressCallback;
+    _hasProgress = false;
+    _lastProgressMs = millis();
+
+    // Ensure I2S is started
+    if (!_speaker->isActive()) {
+        esp_err_t err = _speaker->start();
+        if (err != ESP_OK) {
+            closeFile();
+            return false;
+        }
+    }
+
+    // Start streaming MP3 decode
+    _playing = true;
+    bool success = _decoder.startStreaming(source, 
+        [this](const int16_t* data, size_t sampleCount, MP3Decoder::MP3Info& info) {
+            return streamingCallback(data, sampleCount, info);
+        });
+    
+    if (!success || !negotiateFormat(_decoder.getStreamInfo(), true)) {
+        if (_decoder.isStreaming()) {
+            _decoder.stopStreaming();
+        }
+        closeFile();
+        _playing = false;
+        return false;
+    }
+
+    // Process frames until streaming is complete
+    while (_decoder.isStreaming() && _playing) {
+        MP3Decoder::StreamStatus status = _decoder.decodeNextFrame();
+        reportProgress(status);
+        if (status != MP3Decoder::STREAM_FRAME && status != MP3Decoder::STREAM_BUDGET &&
+            status != MP3Decoder::STREAM_NEED_DATA) {
+            break;
+        }
+        
+        // Small delay to prevent watchdog timeout
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    // Cleanup
+    if (_decoder.isStreaming()) {
+        _decoder.stopStreaming();
+    }
+    closeFile();
+    
+    _playing = false;
+    _progressCallback = nullptr;
+    _speaker->clear();
+    
+    return success;
+}
+
+bool MP3StreamPlayer::play(const String& filePath, float volume) {
+    return play(SPIFFS, filePath, volume);
+}
+
+bool MP3StreamPlayer::play(fs::FS& fs, const String& filePath, float volume) {
+    if (!_initialized || !_speaker || _playing || _decodeTask || _writerTask) {
+        return false;
+    }
+
+    ByteSource* source = openFile(fs, filePath);
+    if (!source) {
+        return false;
+    }
+    if (!play(source, volume)) {
+        closeFile();
+        return false;
+    }
+    return true;
+}
+
+bool MP3StreamPlayer::play(ByteSource* source, float volume) {
+    if (!_initialized || !_speaker || !source || _playing || _decodeTask || _writerTask) {
+        return false;
+    }
+
+    // Tasks of the last playback may still be on their way out
+    waitForTasks();
+
+    // The ring storage is allocated once and kept for later playbacks
+    if (!_pcmRingStorage) {
+        _pcmRingStorage = (int16_t*)heap_caps_malloc(PCM_RING_SAMPLES * sizeof(int16_t), 
+                                                    MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
+        if (!_pcmRingStorage) {
+            return false;
+        }
+        _allocationCount++;
+        _pcmRing.attach(_pcmRingStorage, PCM_RING_SAMPLES);
+    }
+    _pcmRing.reset();
+
+    _volume = constrain(volume, 0.0f, MAX_VOLUME);
+    _gain.resetGain(_volume);
+    _hasProgress = false;
+    _lastProgressMs = millis();
+
+    if (!_speaker->isActive()) {
+        esp_err_t err = _speaker->start();
+        if (err != ESP_OK) {
+            return false;
+        }
+    }
+
+    if (!startAsyncStream(source)) {
+        return false;
+    }
+
+    // No task is running yet, so the speaker can still be switched safely
+    if (!negotiateFormat(_decoder.getStreamInfo(), true)) {
+        _decoder.stopStreaming();
+        return false;
+    }
+
+    _playing = true;
+    _decodeDone = false;
+
+    if (_mixer) {
+        // The mixer pulls from the ring as one of its voices
+        size_t channels = _converter.getOutputChannels();
+        _ringSource.attach(&_pcmRing, channels, PCM_PREBUFFER_SAMPLES / channels);
+        _mixerVoice = _mixer->addVoice(&_ringSource, _volume, _mixerPriority);
+        if (_mixerVoice < 0) {
+            _playing = false;
+            _decoder.stopStreaming();
+            return false;
+        }
+    } else {
+        // Writer first: the decoder task notifies it whenever new PCM is available.
+        // xTaskCreate stores the handle before the task can run, so a task that
+        // finishes at once never leaves a stale handle behind.
+        if (xTaskCreate(writerTask, "mp3_writer", WRITER_TASK_STACK, this, 
+                        WRITER_TASK_PRIORITY, (TaskHandle_t*)&_writerTask) != pdPASS) {
+            _writerTask = nullptr;
+            _playing = false;
+            _decoder.stopStreaming();
+            return false;
+        }
+        _writerStarted = true;
+    }
+
+    if (xTaskCreate(decodeTask, "mp3_decode", DECODE_TASK_STACK, this, 
+                    DECODE_TASK_PRIORITY, (TaskHandle_t*)&_decodeTask) != pdPASS) {
+        _decodeTask = nullptr;
+        // Writer sees end of stream with an empty ring and exits on its own
+        _playing = false;
+        _decodeDone = true;
+        _decoder.stopStreaming();
+        if (_mixer) {
+            releaseVoice();
+        }
+        return false;
+    }
+    _decodeStarted = true;
+
+    return true;
+}
+
+void MP3StreamPlayer::decodeTask(void* param) {
+    MP3StreamPlayer* player = static_cast<MP3StreamPlayer*>(param);
+    player->runDecoder();
+    // Last access to the player: stop() may free it as soon as this is given
+    xSemaphoreGive(player->_decodeStopped);
+    vTaskDelete(nullptr);
+}
+
+void MP3StreamPlayer::runDecoder() {
+    bool nextOpen = false;
+
+    while (true) {
+        while (_decoder.isStreaming() && _playing) {
+            MP3Decoder::StreamStatus status = _decoder.decodeNextFrame();
+            reportProgress(status);
+
+            // The file has been read: open the next track while this one drains
+            if (!nextOpen && _source->isEnd()) {
+                nextOpen = openNextFile();
+            }
+
+            if (status == MP3Decoder::STREAM_FRAME) {
+                continue;  // The ring callback waits for space, which paces the task
+            }
+            if (status != MP3Decoder::STREAM_BUDGET && status != MP3Decoder::STREAM_NEED_DATA) {
+                break;
+            }
+            // Resyncing through garbage or waiting on a live source: let others run
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+
+        if (_decoder.isStreaming()) {
+            _decoder.stopStreaming();
+        }
+        closeFile();
+
+        if (!_playing || (!nextOpen && !openNextFile())) {
+            break;
+        }
+
+        // Continue in the same PCM ring, so the output never sees the track change.
+        // A file without a stream ends the inner loop at once and is skipped.
+        nextOpen = false;
+        _currentFile ^= 1;
+        if (!startAsyncStream(beginFile())) {
+            Serial.printf("MP3StreamPlayer: no MP3 stream in queued file, skipped\n");
+        }
+    }
+
+    if (nextOpen) {
+        _files[_currentFile ^ 1].close();
+    }
+    _source = nullptr;
+
+    _decodeDone = true;
+
+    if (_mixer) {
+        // The voice finishes once the mixer has drained the ring
+        _ringSource.markEnd();
+        while (_playing && _mixer->isVoiceActive(_mixerVoice)) {
+            vTaskDelay(pdMS_TO_TICKS(VOICE_POLL_MS));
+        }
+        releaseVoice();
+        _playing = false;
+    } else {
+        xTaskNotifyGive(_writerTask);
+    }
+
+    _decodeTask = nullptr;
+}
+
+void MP3StreamPlayer::writerTask(void* param) {
+    MP3StreamPlayer* player = static_cast<MP3StreamPlayer*>(param);
+    player->runWriter();
+    xSemaphoreGive(player->_writerStopped);
+    vTaskDelete(nullptr);
+}
+
+void MP3StreamPlayer::runWriter() {
+    bool started = false;
+
+    while (_playing) {
+        size_t available = _pcmRing.available();
+
+        // Prebuffer so early decode jitter does not starve the DMA
+        if (!started && available < PCM_PREBUFFER_SAMPLES && !_decodeDone) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+            continue;
+        }
+        started = true;
+
+        if (available == 0) {
+            if (_decodeDone) {
+                break;
+            }
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        // Render volume-scaled PCM straight into the speaker's write slot
+        size_t capacity;
+        int16_t* slot = (int16_t*)_speaker->acquireBuffer(&capacity);
+        if (!slot) {
+            break;
+        }
+
+        size_t samples = _pcmRing.read(slot, _min(available, capacity / sizeof(int16_t)));
+        _gain.process(slot, slot, samples);
+
+        if (!_speaker->commitBuffer(samples * sizeof(int16_t), 100)) {
+            break;
+        }
+    }
+
+    _playing = false;
+
+    // Wait for the decoder to observe the stop before touching shared state
+    while (_decodeTask) {
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    _speaker->clear();
+
+    _writerTask = nullptr;
+}
+
+void MP3StreamPlayer::stop() {
+    // Whichever task is decoding sees this, then closes the stream and the
+    // file itself. In blocking mode that is the task inside playBlocking().
+    _playing = false;
+
+    // A task stopping its own playback (e.g. from a progress callback) cannot wait for itself
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (self == _decodeTask || self == _writerTask) {
+        return;
+    }
+
+    waitForTasks();
+}
+
+void MP3StreamPlayer::releaseVoice() {
+    // _ringSource is reset and reused by the next playback, so the mixer must
+    // have let go of it before we return
+    while (!_mixer->removeVoice(_mixerVoice)) {
+        Serial.printf("MP3StreamPlayer: waiting for the mixer to release voice %d\n", _mixerVoice);
+    }
+    _mixerVoice = -1;
+}
+
+void MP3StreamPlayer::waitForTasks() {
+    // Tasks use the ring, the queue lock and this object until they give their semaphore
+    if (_decodeStarted) {
+        while (xSemaphoreTake(_decodeStopped, pdMS_TO_TICKS(STOP_TIMEOUT_MS)) != pdTRUE) {
+            Serial.printf("MP3StreamPlayer: waiting for the decoder task to stop\n");
+        }
+        _decodeStarted = false;
+    }
+
+    if (_writerStarted) {
+        while (xSemaphoreTake(_writerStopped, pdMS_TO_TICKS(STOP_TIMEOUT_MS)) != pdTRUE) {
+            Serial.printf("MP3StreamPlayer: waiting for the writer task to stop\n");
+        }
+        _writerStarted = false;
+    }
+}
+
+void MP3StreamPlayer::setVolume(float volume) {
+    _volume = constrain(volume, 0.0f, MAX_VOLUME);
+    _gain.setGain(_volume);
+
+    if (_mixer && _mixerVoice >= 0) {
+        _mixer->setVoiceGain(_mixerVoice, _volume);
+    }
+}
+
+bool MP3StreamPlayer::getFileInfo(const String& filePath, MP3Decoder::MP3Info* info) {
+    if (!_initialized || !info) {
+        return false;
+    }
+    
+    return _decoder.getFileInfo(filePath, info);
+}
+
+void MP3StreamPlayer::setPrefetch(size_t depth, size_t blockSize) {
+    _prefetchDepth = depth;
+    _prefetchBlockSize = blockSize;
+}
+
+PrefetchByteSource::Stats MP3StreamPlayer::getPrefetchStats() const {
+    return _prefetch.getStats();
+}
+
+ByteSource* MP3StreamPlayer::openFile(fs::FS& fs, const String& filePath) {
+    if (!_files[_currentFile].open(fs, filePath)) {
+        return nullptr;
+    }
+    return beginFile();
+}
+
+ByteSource* MP3StreamPlayer::beginFile() {
+    FileByteSource* file = &_files[_currentFile];
+    if (_prefetchDepth == 0) {
+        return file;
+    }
+
+    // Fall back to direct reads if the prefetch task cannot be started
+    if (!_prefetch.begin(file, _prefetchBlockSize, _prefetchDepth)) {
+        Serial.printf("MP3 prefetch unavailable, reading the file directly\n");
+        return file;
+    }
+    return &_prefetch;
+}
+
+void MP3StreamPlayer::closeFile() {
+    // The prefetch task reads the file, so it stops first
+    _prefetch.end();
+    _files[_currentFile].close();
+}
+
+bool MP3StreamPlayer::startAsyncStream(ByteSource* source) {
+    _source = source;
+    return _decoder.startStreaming(source,
+        [this](const int16_t* data, size_t sampleCount, MP3Decoder::MP3Info& info) {
+            return asyncStreamingCallback(data, sampleCount, info);
+        });
+}
+
+bool MP3StreamPlayer::enqueue(const String& filePath) {
+    return enqueue(SPIFFS, filePath);
+}
+
+bool MP3StreamPlayer::enqueue(fs::FS& fs, const String& filePath) {
+    if (!_initialized) {
+        return false;
+    }
+
+    xSemaphoreTake(_queueLock, portMAX_DELAY);
+    bool added = _queueCount < MAX_QUEUE;
+    if (added) {
+        QueueEntry& entry = _queue[(_queueHead + _queueCount) % MAX_QUEUE];
+        entry.fs = &fs;
+        entry.path = filePath;
+        _queueCount++;
+    }
+    xSemaphoreGive(_queueLock);
+    return added;
+}
+
+bool MP3StreamPlayer::popQueue(QueueEntry* entry) {
+    if (!_queueLock) {
+        return false;
+    }
+
+    xSemaphoreTake(_queueLock, portMAX_DELAY);
+    bool found = _queueCount > 0;
+    if (found) {
+        *entry = _queue[_queueHead];
+        _queue[_queueHead].path = String();
+        _queueHead = (_queueHead + 1) % MAX_QUEUE;
+        _queueCount--;
+    }
+    xSemaphoreGive(_queueLock);
+    return found;
+}
+
+bool MP3StreamPlayer::openNextFile() {
+    QueueEntry entry;
+    while (popQueue(&entry)) {
+        if (_files[_currentFile ^ 1].open(*entry.fs, entry.path)) {
+            return true;
+        }
+        Serial.printf("MP3StreamPlayer: cannot open %s, skipped\n", entry.path.c_str());
+    }
+    return false;
+}
+
+bool MP3StreamPlayer::playQueue(float volume) {
+    if (!_initialized || !_speaker || _playing || _decodeTask || _writerTask) {
+        return false;
+    }
+
+    // The first playable file starts the tasks, which take the rest from the queue
+    QueueEntry entry;
+    while (popQueue(&entry)) {
+        if (play(*entry.fs, entry.path, volume)) {
+            return true;
+        }
+        Serial.printf("MP3StreamPlayer: cannot play %s, skipped\n", entry.path.c_str());
+    }
+    return false;
+}
+
+void MP3StreamPlayer::clearQueue() {
+    if (!_queueLock) {
+        return;
+    }
+
+    xSemaphoreTake(_queueLock, portMAX_DELAY);
+    while (_queueCount > 0) {
+        _queue[_queueHead].path = String();
+        _queueHead = (_queueHead + 1) % MAX_QUEUE;
+        _queueCount--;
+    }
+    xSemaphoreGive(_queueLock);
+}
+
+size_t MP3StreamPlayer::getQueueLength() const {
+    return _queueCount;
+}
+
+void MP3StreamPlayer::setGapless(bool enabled) {
+    _decoder.setGapless(enabled);
+}
+
+bool MP3StreamPlayer::negotiateFormat(const MP3Decoder::MP3Info& info, bool allowSpeakerChange) {
+    if (!_speaker || info.sampleRate <= 0 || info.channels <= 0) {
+        return false;
+    }
+
+    // A mixer owns the speaker and may be playing other voices at its format
+    if (allowSpeakerChange && _formatPolicy == FORMAT_RECONFIGURE_SPEAKER && !_mixer && 
+        !_speaker->isPlaying()) {
+        i2s_slot_mode_t mode = (info.channels == 1) ? I2S_SLOT_MODE_MONO : I2S_SLOT_MODE_STEREO;
+        if (_speaker->reconfigure(info.sampleRate, mode) != ESP_OK) {
+            Serial.printf("MP3StreamPlayer: speaker reconfiguration failed, converting instead\n");
+        }
+    }
+
+    return _converter.configure(info.sampleRate, info.channels, 
+                                _speaker->getSampleRate(), _speaker->getChannelCount(), _resamplerQuality);
+}
+
+bool MP3StreamPlayer::streamingCallback(const int16_t* data, size_t sampleCount, 
+                                 MP3Decoder::MP3Info& info) {
+    if (!_speaker || !_playing || !data || sampleCount == 0) {
+        return false;
+    }
+
+    // Format changed mid-stream: the speaker is busy now, adapt by converting
+    if (!_converter.matchesSource(info.sampleRate, info.channels) && !negotiateFormat(info, false)) {
+        return false;
+    }
+
+    if (_converter.isPassthrough()) {
+        // Render volume-scaled samples straight into the speaker's write slot,
+        // one slot at a time, so no per-frame buffer is needed
+        size_t offset = 0;
+        while (offset < sampleCount) {
+            size_t capacity;
+            int16_t* slot = (int16_t*)_speaker->acquireBuffer(&capacity);
+            if (!slot) {
+                return false;
+            }
+
+            size_t chunk = _min(sampleCount - offset, capacity / sizeof(int16_t));
+            _gain.process(data + offset, slot, chunk);
+
+            if (!_speaker->commitBuffer(chunk * sizeof(int16_t), 100)) {
+                return false; // Stop streaming on I2S error
+            }
+            offset += chunk;
+        }
+    } else {
+        // Convert into the write slot, then scale in place
+        size_t inChannels = _converter.getInputChannels();
+        size_t outChannels = _converter.getOutputChannels();
+        size_t framesLeft = sampleCount / inChannels;
+
+        while (framesLeft > 0) {
+            size_t capacity;
+            int16_t* slot = (int16_t*)_speaker->acquireBuffer(&capacity);
+            if (!slot) {
+                return false;
+            }
+
+            size_t consumed = 0;
+            size_t produced = _converter.process(data, framesLeft, slot, 
+                                                 capacity / (outChannels * sizeof(int16_t)), &consumed);
+            _gain.process(slot, slot, produced * outChannels);
+
+            if (!_speaker->commitBuffer(produced * outChannels * sizeof(int16_t), 100)) {
+                return false; // Stop streaming on I2S error
+            }
+            data += consumed * inChannels;
+            framesLeft -= consumed;
+        }
+    }
+
+    return _playing; // Continue streaming if still playing
+}
+
+bool MP3StreamPlayer::asyncStreamingCallback(const int16_t* data, size_t sampleCount,
+                                      MP3Decoder::MP3Info& info) {
+    if (!data || sampleCount == 0) {
+        return _playing;
+    }
+
+    if (!_converter.matchesSource(info.sampleRate, info.channels) && !negotiateFormat(info, false)) {
+        return false;
+    }
+
+    // Convert straight into the ring (a plain copy when the formats match)
+    size_t inChannels = _converter.getInputChannels();
+    size_t outChannels = _converter.getOutputChannels();
+    size_t framesLeft = sampleCount / inChannels;
+
+    while (framesLeft > 0) {
+        if (!_playing) {
+            return false;
+        }
+
+        size_t region;
+        int16_t* dst = _pcmRing.writeRegion(&region);
+        size_t regionFrames = region / outChannels;
+
+        if (regionFrames == 0) {
+            // Ring full: the writer is draining at the I2S rate
+            vTaskDelay(pdMS_TO_TICKS(1));
+            continue;
+        }
+
+        size_t consumed = 0;
+        size_t produced = _converter.process(data, framesLeft, dst, regionFrames, &consumed);
+        _pcmRing.commitWrite(produced * outChannels);
+        data += consumed * inChannels;
+        framesLeft -= consumed;
+
+        if (produced > 0 && _writerTask) {
+            xTaskNotifyGive(_writerTask);
+        }
+    }
+
+    return _playing;
+}
+
+void MP3StreamPlayer::reportProgress(MP3Decoder::StreamStatus status) {
+    // A stopped or failed stream keeps the last position reported
+    bool finished = (status == MP3Decoder::STREAM_END);
+    if (status != MP3Decoder::STREAM_FRAME && !finished) {
+        return;
+    }
+
+    uint32_t now = millis();
+    if (!finished && _hasProgress && now - _lastProgressMs < _progressIntervalMs) {
+        return;
+    }
+
+    MP3Decoder::Progress progress;
+    if (!_decoder.getProgress(&progress)) {
+        return;
+    }
+    if (finished) {
+        // Trailing tags are never decoded, the stream still played to the end
+        progress.fraction = 1.0f;
+        progress.durationMs = progress.elapsedMs;
+        progress.remainingMs = 0;
+    }
+
+    // getProgress() copies the report from the caller's task
+    xSemaphoreTake(_queueLock, portMAX_DELAY);
+    _progress = progress;
+    _hasProgress = true;
+    xSemaphoreGive(_queueLock);
+    _lastProgressMs = now;
+    if (_progressCallback) {
+        _progressCallback(progress);
+    }
+}
+
+bool MP3StreamPlayer::getProgress(MP3Decoder::Progress* progress) const {
+    if (!progress || !_queueLock) {
+        return false;
+    }
+
+    xSemaphoreTake(_queueLock, portMAX_DELAY);
+    bool found = _hasProgress;
+    if (found) {
+        *progress = _progress;
+    }
+    xSemaphoreGive(_queueLock);
+    return found;
+}
+
+void MP3StreamPlayer::setProgressInterval(uint32_t intervalMs) {
+    _progressIntervalMs = intervalMs;
+}
+
+size_t MP3StreamPlayer::getAllocationCount() const {
+    return countAllocations() - _allocationBase;
+}
+
+void MP3StreamPlayer::resetAllocationCount() {
+    _allocationBase = countAllocations();
+}
+
+size_t MP3StreamPlayer::countAllocations() const {
+    return _allocationCount + _decoder.getAllocationCount() + _converter.getAllocationCount() +
+           _prefetch.getAllocationCount();
+}
+
+size_t MP3StreamPlayer::getMemoryUsage() const {
+    size_t bytes = _decoder.getMemoryUsage() + _prefetch.getBufferSize();
+    if (_pcmRingStorage) {
+        bytes += PCM_RING_SAMPLES * sizeof(int16_t);
+    }
+    return bytes;
+}
+
+void MP3StreamPlayer::setFormatPolicy(FormatPolicy policy) {
+    _formatPolicy = policy;
+}
+
+void MP3StreamPlayer::setResamplerQuality(Resampler::Quality quality) {
+    _resamplerQuality = quality;
+}
+
+void MP3StreamPlayer::setMixer(AudioMixer* mixer, uint8_t priority) {
+    _mixer = mixer;
+    _mixerPriority = priority;
+}
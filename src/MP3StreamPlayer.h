@@ -0,0 +1,553 @@
+#pragma once
+
+#include "I2SSpeaker.h"
+#include "MP3Decoder.h"
+#include "SpscRingBuffer.h"
+#include "GainKernel.h"
+#include "FormatConverter.h"
+#include "AudioMixer.h"
+#include "PrefetchByteSource.h"
+
+/**
+ * MP3 player instance that combines MP3 decoding with I2S output streaming
+ *
+ * Each instance owns its decoder, file source, PCM ring and tasks, so
+ * several streams can play at once: one per I2S port, or several voices
+ * of one mixer (music plus a voice prompt). Two instances must not write
+ * to the same speaker directly; share it through a mixer instead.
+ *
+ * Playback is either blocking (playFile / playFileWithProgress) or
+ * asynchronous (play), where a decoder task and a writer task are
+ * decoupled by a lock-free PCM ring buffer.
+ *
+ * The Helix decoder and the stream buffers are allocated by init() and
+ * the first playback, then reused for every following file.
+ *
+ * Streams whose sample rate or channel count differ from the speaker are
+ * adapted before output, see FormatPolicy.
+ *
+ * With a mixer attached (setMixer), asynchronous playback becomes a mixer
+ * voice fed from the PCM ring, so other sounds can play on top of it.
+ *
+ * Files added with enqueue() play back to back on the asynchronous path
+ * without stopping the speaker, trimmed for gapless joins.
+ */
+class MP3StreamPlayer {
+public:
+    static constexpr float MAX_VOLUME = 2.0f;  // +6 dB, output saturates
+    static const uint32_t DEFAULT_PROGRESS_INTERVAL_MS = 250;
+
+    // Callback for playback position, see MP3Decoder::getProgress()
+    using ProgressCallback = std::function<void(const MP3Decoder::Progress&)>;
+
+    /**
+     * How a stream format that differs from the speaker is handled
+     */
+    enum FormatPolicy {
+        FORMAT_CONVERT,             // Mix channels and resample to the speaker format
+        FORMAT_RECONFIGURE_SPEAKER  // Switch the speaker to the stream format if it is idle, else convert
+    };
+
+    MP3StreamPlayer();
+    ~MP3StreamPlayer();
+
+    // Tasks hold a pointer to the instance
+    MP3StreamPlayer(const MP3StreamPlayer&) = delete;
+    MP3StreamPlayer& operator=(const MP3StreamPlayer&) = delete;
+
+    /**
+     * Initialize the player with an I2S speaker
+     *
+     * @param speaker Pointer to initialized I2SSpeaker
+     * @return true if the decoder was created
+     */
+    bool init(I2SSpeaker* speaker);
+
+    /**
+     * Play MP3 file from SPIFFS with streaming (memory efficient)
+     *
+     * @param filePath Path to MP3 file in SPIFFS
+     * @param volume Volume level (0.0 to 2.0)
+     * @return true if playback completed successfully
+     */
+    bool playFile(const String& filePath, float volume = 0.7f);
+
+    /**
+     * Play MP3 file from any filesystem with streaming
+     *
+     * @param fs Filesystem holding the file (SPIFFS, LittleFS, SD, ...)
+     * @param filePath Path to MP3 file
+     * @param volume Volume level (0.0 to 2.0)
+     * @return true if playback completed successfully
+     */
+    bool playFile(fs::FS& fs, const String& filePath, float volume = 0.7f);
+
+    /**
+     * Play MP3 file with streaming and progress callback
+     *
+     * @param filePath Path to MP3 file in SPIFFS
+     * @param volume Volume level (0.0 to 2.0)
+     * @param progressCallback Callback for playback progress (0.0 to 1.0)
+     * @return true if playback completed successfully
+     */
+    bool playFileWithProgress(const String& filePath, float volume = 0.7f,
+                              std::function<void(float)> progressCallback = nullptr);
+
+    /**
+     * Play MP3 file from any filesystem with position and time reports
+     *
+     * The callback runs on the decoding task every progress interval and
+     * once more at the end of the file (fraction 1.0 when it played to the
+     * end). Build or load a frame index first (MP3Decoder::prepareIndex)
+     * for exact VBR durations.
+     *
+     * @param fs Filesystem holding the file (SPIFFS, LittleFS, SD, ...)
+     * @param filePath Path to MP3 file
+     * @param volume Volume level (0.0 to 2.0)
+     * @param progressCallback Callback for playback progress
+     * @return true if playback completed successfully
+     */
+    bool playFileWithProgress(fs::FS& fs, const String& filePath, float volume,
+                              ProgressCallback progressCallback);
+
+    /**
+     * Start asynchronous MP3 playback and return immediately
+     *
+     * A decoder task fills a PCM ring buffer while a writer task drains it
+     * into the speaker, so decode jitter (slow reads, resync) is absorbed
+     * by the ring instead of causing underruns. Use isPlaying() to poll
+     * for completion and stop() to abort.
+     *
+     * @param filePath Path to MP3 file in SPIFFS
+     * @param volume Volume level (0.0 to 2.0)
+     * @return true if playback tasks were started
+     */
+    bool play(const String& filePath, float volume = 0.7f);
+
+    /**
+     * Start asynchronous playback of a file on any filesystem
+     *
+     * @param fs Filesystem holding the file (SPIFFS, LittleFS, SD, ...)
+     * @param filePath Path to MP3 file
+     * @param volume Volume level (0.0 to 2.0)
+     * @return true if playback tasks were started
+     */
+    bool play(fs::FS& fs, const String& filePath, float volume = 0.7f);
+
+    /**
+     * Start asynchronous playback from a byte source (memory, network ring, ...)
+     *
+     * @param source Source of encoded data (not owned, must stay valid until playback ends)
+     * @param volume Volume level (0.0 to 2.0)
+     * @return true if playback tasks were started
+     */
+    bool play(ByteSource* source, float volume = 0.7f);
+
+    /**
+     * Add a file to the play queue
+     * 
+     * When asynchronous playback reaches the end of a stream, the decoder
+     * task continues with the next queued file. It opens that file as soon
+     * as the current one has been read, and decodes its first frames into
+     * the PCM ring while the output still drains the current track, so the
+     * speaker keeps running between tracks. With gapless trimming the
+     * tracks join sample-exact when they carry a LAME header.
+     * 
+     * The queue is kept by stop(); use clearQueue() to empty it.
+     * 
+     * @param fs Filesystem holding the file (SPIFFS, LittleFS, SD, ...)
+     * @param filePath Path to MP3 file
+     * @return false if the player is not initialized or the queue is full
+     */
+    bool enqueue(fs::FS& fs, const String& filePath);
+
+    /**
+     * Add a file in SPIFFS to the play queue
+     * 
+     * @param filePath Path to MP3 file in SPIFFS
+     * @return false if the player is not initialized or the queue is full
+     */
+    bool enqueue(const String& filePath);
+
+    /**
+     * Start asynchronous playback of the queued files
+     * 
+     * Files that cannot be opened or played are skipped.
+     * 
+     * @param volume Volume level (0.0 to 2.0)
+     * @return true if a queued file started playing
+     */
+    bool playQueue(float volume = 0.7f);
+
+    /**
+     * Remove all files from the play queue
+     * 
+     * The current track plays on; a next track already opened still follows.
+     */
+    void clearQueue();
+
+    /**
+     * Get the number of queued files
+     * 
+     * @return Files waiting to be played
+     */
+    size_t getQueueLength() const;
+
+    /**
+     * Trim encoder delay and padding, see MP3Decoder::setGapless()
+     * 
+     * Takes effect from the next track.
+     * 
+     * @param enabled true to trim (default true)
+     */
+    void setGapless(bool enabled);
+
+    /**
+     * Stop current playback
+     * 
+     * Asynchronous playback has fully stopped when this returns. Blocking
+     * playback on another task is asked to stop and cleans up itself.
+     */
+    void stop();
+
+    /**
+     * Check if currently playing
+     *
+     * @return true if playing
+     */
+    bool isPlaying() const { return _playing; }
+
+    /**
+     * Get the position of the current or last playback
+     *
+     * Can be polled during asynchronous playback. Elapsed time counts
+     * decoded samples, so it runs ahead of the output by the PCM buffered
+     * in between.
+     *
+     * @param progress Output progress
+     * @return false if nothing has been played yet
+     */
+    bool getProgress(MP3Decoder::Progress* progress) const;
+
+    /**
+     * Set how often progress callbacks are made
+     *
+     * @param intervalMs Minimum time between reports, 0 to report every frame
+     */
+    void setProgressInterval(uint32_t intervalMs);
+
+    /**
+     * Set volume during playback
+     *
+     * The change is ramped over a few milliseconds to avoid clicks.
+     *
+     * @param volume Volume level (0.0 to 2.0, above 1.0 amplifies with saturation)
+     */
+    void setVolume(float volume);
+
+    /**
+     * Get current volume
+     *
+     * @return Current volume level
+     */
+    float getVolume() const { return _volume; }
+
+    /**
+     * Get MP3 file information without playing
+     *
+     * @param filePath Path to MP3 file in SPIFFS
+     * @param info Output MP3 information
+     * @return true if successful
+     */
+    bool getFileInfo(const String& filePath, MP3Decoder::MP3Info* info);
+
+    /**
+     * Get the decoder of this player
+     *
+     * Use it to prepare a frame index before playback; it must not be
+     * used for other streams while the player is playing.
+     *
+     * @return Decoder owned by the player
+     */
+    MP3Decoder& getDecoder() { return _decoder; }
+
+    /**
+     * Get number of heap allocations made by this player's playback path
+     *
+     * Counts the decoder buffers, the format converter's filter tables, the
+     * prefetch buffer and the PCM ring. Steady-state playback renders into
+     * pre-sized buffers, so this count must not grow while a file is
+     * playing. Handles opened by the filesystem are not included.
+     *
+     * @return Allocation count since init() or the last reset
+     */
+    size_t getAllocationCount() const;
+
+    /**
+     * Reset the allocation counter
+     */
+    void resetAllocationCount();
+
+    /**
+     * Get the heap memory held by this player
+     *
+     * Counts the decoder buffers, the PCM ring and the prefetch buffer; the
+     * Helix decoder's internal state is not included.
+     *
+     * @return Bytes allocated
+     */
+    size_t getMemoryUsage() const;
+
+    /**
+     * Set how streams in a different format than the speaker are played
+     *
+     * FORMAT_RECONFIGURE_SPEAKER plays the stream bit-exact but leaves the
+     * speaker in the stream's format afterwards; other producers sharing the
+     * speaker must not be writing when playback starts.
+     *
+     * @param policy Format policy (default FORMAT_CONVERT)
+     */
+    void setFormatPolicy(FormatPolicy policy);
+
+    /**
+     * Get the current format policy
+     *
+     * @return Format policy
+     */
+    FormatPolicy getFormatPolicy() const { return _formatPolicy; }
+
+    /**
+     * Set resampler quality used when the stream rate differs from the speaker
+     *
+     * Takes effect from the next playback.
+     *
+     * @param quality Resampler quality (default QUALITY_MEDIUM)
+     */
+    void setResamplerQuality(Resampler::Quality quality);
+
+    /**
+     * Play through a mixer instead of writing to the speaker directly
+     *
+     * The decoded stream becomes a mixer voice and the volume its voice
+     * gain. The blocking play functions wait on the asynchronous path in
+     * this mode. The speaker format is never changed while a mixer is set.
+     * Takes effect from the next playback.
+     *
+     * @param mixer Running mixer that owns the speaker, nullptr to write directly again
+     * @param priority Voice priority (ducked below higher-priority voices)
+     */
+    void setMixer(AudioMixer* mixer, uint8_t priority = AudioMixer::PRIORITY_BACKGROUND);
+
+    /**
+     * Read files ahead on a separate task
+     *
+     * Path-based playback then reads the file through a PrefetchByteSource,
+     * so the decoder only copies from memory and slow flash or SD reads are
+     * absorbed by the read-ahead. Takes effect from the next playback.
+     *
+     * @param depth Blocks to read ahead (2 = double buffer), 0 to read directly
+     * @param blockSize Bytes per file read
+     */
+    void setPrefetch(size_t depth, size_t blockSize = PrefetchByteSource::DEFAULT_BLOCK_SIZE);
+
+    /**
+     * Get prefetch hit/miss counters of the current or last file
+     *
+     * @return Prefetch statistics
+     */
+    PrefetchByteSource::Stats getPrefetchStats() const;
+
+private:
+    I2SSpeaker* _speaker;
+    MP3Decoder _decoder;
+    bool _initialized;
+    volatile bool _playing;
+    float _volume;
+    GainKernel _gain;
+    ProgressCallback _progressCallback;
+    uint32_t _progressIntervalMs;
+    uint32_t _lastProgressMs;
+    MP3Decoder::Progress _progress;  // Last report, written by the decoding task
+    bool _hasProgress;
+    size_t _allocationCount;         // PCM ring allocations
+    size_t _allocationBase;          // Total at init() or the last reset
+    FormatPolicy _formatPolicy;
+    FormatConverter _converter;
+    Resampler::Quality _resamplerQuality;
+    FileByteSource _files[2];     // Current and next file of path-based playback
+    uint8_t _currentFile;         // Slot of the current file in _files
+    ByteSource* _source;          // Source of the current asynchronous stream
+    PrefetchByteSource _prefetch; // Optional read-ahead over the current file
+    size_t _prefetchDepth;
+    size_t _prefetchBlockSize;
+
+    // Mixer output
+    AudioMixer* _mixer;
+    uint8_t _mixerPriority;
+    volatile int _mixerVoice;
+    RingAudioSource _ringSource;
+    static const uint32_t VOICE_POLL_MS = 10;
+
+    // Asynchronous playback
+    static const size_t PCM_RING_SAMPLES = 16384;     // Must be a power of two
+    static const size_t PCM_PREBUFFER_SAMPLES = 4096; // Buffered before the writer starts
+    static const uint32_t DECODE_TASK_STACK = 8192;
+    static const uint32_t WRITER_TASK_STACK = 4096;
+    static const UBaseType_t DECODE_TASK_PRIORITY = 5;
+    static const UBaseType_t WRITER_TASK_PRIORITY = 6;
+    static const uint32_t STOP_TIMEOUT_MS = 500;       // Log interval while stop() waits for the tasks
+
+    // Play queue
+    static const size_t MAX_QUEUE = 16;
+
+    struct QueueEntry {
+        fs::FS* fs;
+        String path;
+    };
+
+    QueueEntry _queue[MAX_QUEUE];
+    size_t _queueHead;
+    size_t _queueCount;
+    SemaphoreHandle_t _queueLock;  // Guards the queue and _progress across the caller's and decoder task
+
+    PcmRingBuffer _pcmRing;
+    int16_t* _pcmRingStorage;
+    TaskHandle_t volatile _decodeTask;
+    TaskHandle_t volatile _writerTask;
+    SemaphoreHandle_t _decodeStopped;  // Given by the decoder task right before it deletes itself
+    SemaphoreHandle_t _writerStopped;  // Given by the writer task right before it deletes itself
+    bool _decodeStarted;               // Task started and its stop not yet collected
+    bool _writerStarted;
+    volatile bool _decodeDone;
+
+    /**
+     * Match the output path to a stream format
+     *
+     * Reconfigures the speaker when the policy allows it, then sets up the
+     * converter from the stream format to the speaker format.
+     *
+     * @param info MP3 stream information
+     * @param allowSpeakerChange false once PCM has been queued to the speaker
+     * @return true if the stream format is supported
+     */
+    bool negotiateFormat(const MP3Decoder::MP3Info& info, bool allowSpeakerChange);
+
+    /**
+     * Open a file for path-based playback, behind the prefetch stage if enabled
+     *
+     * @param fs Filesystem holding the file
+     * @param filePath Path to MP3 file
+     * @return Source to decode, nullptr if the file cannot be opened
+     */
+    ByteSource* openFile(fs::FS& fs, const String& filePath);
+
+    /**
+     * Stop the prefetch stage and close the file opened by openFile()
+     */
+    void closeFile();
+
+    /**
+     * Remove the mixer voice, waiting as long as the mixer still reads the ring
+     */
+    void releaseVoice();
+
+    /**
+     * Block until the tasks of the last asynchronous playback have exited
+     */
+    void waitForTasks();
+
+    /**
+     * Sum the allocations of the ring, decoder, converter and prefetch stage
+     */
+    size_t countAllocations() const;
+
+    /**
+     * Read the current file slot, behind the prefetch stage if enabled
+     * 
+     * @return Source to decode
+     */
+    ByteSource* beginFile();
+
+    /**
+     * Take the first file from the play queue
+     * 
+     * @param entry Output queue entry
+     * @return false if the queue is empty
+     */
+    bool popQueue(QueueEntry* entry);
+
+    /**
+     * Open the next playable queued file in the spare file slot
+     * 
+     * @return false if no queued file could be opened
+     */
+    bool openNextFile();
+
+    /**
+     * Start decoding a source into the PCM ring
+     * 
+     * @param source Source of encoded data
+     * @return true if a stream was found
+     */
+    bool startAsyncStream(ByteSource* source);
+
+    /**
+     * Decode a source to the speaker on the calling task
+     *
+     * @param source Source of encoded data
+     * @param volume Volume level (0.0 to 2.0)
+     * @param progressCallback Callback for playback progress
+     * @return true if playback completed successfully
+     */
+    bool playBlocking(ByteSource* source, float volume, ProgressCallback progressCallback);
+
+    /**
+     * Record the decoder position and report it once the interval has passed
+     *
+     * Called on the decoding task after each decode step.
+     *
+     * @param status Result of the last decode step; STREAM_END reports completion
+     */
+    void reportProgress(MP3Decoder::StreamStatus status);
+
+    /**
+     * Streaming callback for blocking playback: writes PCM to the speaker
+     *
+     * @param data PCM audio data
+     * @param sampleCount Number of samples
+     * @param info MP3 stream information
+     * @return true to continue streaming, false to stop
+     */
+    bool streamingCallback(const int16_t* data, size_t sampleCount,
+                           MP3Decoder::MP3Info& info);
+
+    /**
+     * Streaming callback used by the decoder task in asynchronous mode
+     *
+     * Pushes decoded PCM into the ring buffer, waiting for space as needed.
+     *
+     * @param data PCM audio data
+     * @param sampleCount Number of samples
+     * @param info MP3 stream information
+     * @return true to continue streaming, false to stop
+     */
+    bool asyncStreamingCallback(const int16_t* data, size_t sampleCount,
+                                MP3Decoder::MP3Info& info);
+
+    /**
+     * Decoder task: decodes frames into the PCM ring until end of file
+     *
+     * @param param Player instance
+     */
+    static void decodeTask(void* param);
+
+    /**
+     * Writer task: drains the PCM ring into the speaker
+     *
+     * @param param Player instance
+     */
+    static void writerTask(void* param);
+
+    void runDecoder();
+    void runWriter();
+};
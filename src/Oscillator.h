@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Oscillator - wavetable / phase-accumulator tone generator
+ *
+ * Phase is a 32-bit unsigned accumulator where a full cycle is 2^32, so it
+ * wraps for free and never loses precision on long tones. Sine output comes
+ * from a wavetable shared by all oscillators with linear interpolation;
+ * square, triangle and sawtooth are derived from the phase directly.
+ *
+ * A per-sample increment delta turns the oscillator into a linear chirp,
+ * which is what frequency sweeps use.
+ */
+class Oscillator {
+public:
+    enum Waveform {
+        SINE,
+        SQUARE,
+        TRIANGLE,
+        SAWTOOTH,
+        NOISE
+    };
+
+    static const uint32_t TABLE_BITS = 10;
+    static const uint32_t TABLE_SIZE = 1 << TABLE_BITS;
+
+    /**
+     * Constructor
+     *
+     * @param sampleRate Sample rate in Hz
+     * @param waveform Waveform type
+     */
+    Oscillator(uint32_t sampleRate = 16000, Waveform waveform = SINE);
+
+    /**
+     * Set sample rate (keeps the current frequency)
+     *
+     * @param sampleRate Sample rate in Hz
+     */
+    void setSampleRate(uint32_t sampleRate);
+
+    /**
+     * Set frequency and stop any sweep
+     *
+     * @param frequency Frequency in Hz
+     */
+    void setFrequency(float frequency);
+
+    /**
+     * Sweep linearly from the current frequency to a target
+     *
+     * @param endFrequency Frequency in Hz reached after sampleCount samples
+     * @param sampleCount Sweep length in samples
+     */
+    void sweepTo(float endFrequency, size_t sampleCount);
+
+    /**
+     * Set waveform type
+     *
+     * @param waveform Waveform type
+     */
+    void setWaveform(Waveform waveform);
+
+    /**
+     * Set output amplitude
+     *
+     * @param amplitude Amplitude (0.0 to 1.0)
+     */
+    void setAmplitude(float amplitude);
+
+    /**
+     * Reset phase
+     *
+     * @param phase Phase, 2^32 is a full cycle
+     */
+    void resetPhase(uint32_t phase = 0);
+
+    /**
+     * Generate the next sample
+     *
+     * @return Sample at the configured amplitude
+     */
+    int16_t next();
+
+    /**
+     * Render frames, writing the same sample to every channel
+     *
+     * @param buffer Output buffer (interleaved)
+     * @param frames Number of frames
+     * @param channels Number of interleaved channels
+     */
+    void render(int16_t* buffer, size_t frames, size_t channels = 1);
+
+    /**
+     * Render frames and add them to existing content (saturating)
+     *
+     * @param buffer Input/output buffer (interleaved)
+     * @param frames Number of frames
+     * @param channels Number of interleaved channels
+     */
+    void renderAdd(int16_t* buffer, size_t frames, size_t channels = 1);
+
+    /**
+     * Look up the shared sine table with linear interpolation
+     *
+     * @param phase Phase, 2^32 is a full cycle
+     * @return Sine value in Q15
+     */
+    static int16_t sine(uint32_t phase);
+
+    /**
+     * Convert a frequency to a phase increment
+     *
+     * @param frequency Frequency in Hz
+     * @param sampleRate Sample rate in Hz
+     * @return Phase increment per sample
+     */
+    static uint32_t phaseIncrement(float frequency, uint32_t sampleRate);
+
+private:
+    static const int16_t _sineTable[TABLE_SIZE + 1];  // Extra guard entry for interpolation
+
+    uint32_t _sampleRate;
+    Waveform _waveform;
+    uint32_t _phase;
+    uint32_t _increment;
+    int32_t _incrementDelta;    // Per-sample increment change while sweeping
+    size_t _sweepRemaining;
+    int32_t _amplitudeQ15;
+    uint32_t _noiseState;
+
+    /**
+     * Generate the next raw full-scale sample and advance the phase
+     *
+     * @return Sample in Q15
+     */
+    int32_t nextRaw();
+};
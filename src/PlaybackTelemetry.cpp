@@ -0,0 +1,101 @@
+#include "PlaybackTelemetry.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+#define IRAM_ATTR
+#endif
+
+PlaybackTelemetry::PlaybackTelemetry()
+    : _frameBytes(4), _queuedBytes(0), _sentBytes(0), _underruns(0), _queueOverflows(0),
+      _idle(true), _starved(false), _writeCount(0), _maxWriteBlockUs(0) {
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        _histogram[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void PlaybackTelemetry::setFrameBytes(size_t frameBytes) {
+    _frameBytes = frameBytes ? (uint32_t)frameBytes : 1;
+}
+
+void PlaybackTelemetry::reset() {
+    // Keep queued/sent aligned so in-flight data is not mistaken for an underrun.
+    // Sent is taken first: between the two steps pending only looks larger.
+    uint32_t sent = _sentBytes.exchange(0, std::memory_order_acq_rel);
+    _queuedBytes.fetch_sub(sent, std::memory_order_acq_rel);
+    _underruns.store(0, std::memory_order_relaxed);
+    _queueOverflows.store(0, std::memory_order_relaxed);
+    _writeCount.store(0, std::memory_order_relaxed);
+    _maxWriteBlockUs.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        _histogram[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void PlaybackTelemetry::onQueued(size_t bytes) {
+    if (bytes == 0) {
+        return;
+    }
+    _queuedBytes.fetch_add((uint32_t)bytes, std::memory_order_release);
+    _idle.store(false, std::memory_order_relaxed);
+    _starved.store(false, std::memory_order_relaxed);
+}
+
+void PlaybackTelemetry::recordWrite(uint32_t blockedUs) {
+    _writeCount.fetch_add(1, std::memory_order_relaxed);
+    uint32_t longest = _maxWriteBlockUs.load(std::memory_order_relaxed);
+    while (blockedUs > longest &&
+           !_maxWriteBlockUs.compare_exchange_weak(longest, blockedUs, std::memory_order_relaxed)) {
+    }
+
+    size_t bucket = 0;
+    uint32_t bound = FIRST_BUCKET_US;
+    while (bucket < LATENCY_BUCKETS - 1 && blockedUs >= bound) {
+        bucket++;
+        bound <<= 1;
+    }
+    _histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void PlaybackTelemetry::markIdle() {
+    _idle.store(true, std::memory_order_relaxed);
+}
+
+bool IRAM_ATTR PlaybackTelemetry::onSent(size_t bytes) {
+    uint32_t sent = _sentBytes.load(std::memory_order_relaxed);
+    uint32_t pending = _queuedBytes.load(std::memory_order_acquire) - sent;
+
+    // Added, not stored, so a concurrent reset() on another core is not undone
+    if (pending >= bytes) {
+        _sentBytes.fetch_add((uint32_t)bytes, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Descriptor went out (partly) padded with silence by the driver
+    _sentBytes.fetch_add(pending, std::memory_order_relaxed);
+
+    if (_idle.load(std::memory_order_relaxed) || _starved.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    _starved.store(true, std::memory_order_relaxed);
+    _underruns.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void IRAM_ATTR PlaybackTelemetry::onQueueOverflow() {
+    _queueOverflows.fetch_add(1, std::memory_order_relaxed);
+}
+
+PlaybackTelemetry::Snapshot PlaybackTelemetry::snapshot() const {
+    Snapshot snap;
+    snap.framesSent = _sentBytes.load(std::memory_order_relaxed) / _frameBytes;
+    snap.underruns = _underruns.load(std::memory_order_relaxed);
+    snap.queueOverflows = _queueOverflows.load(std::memory_order_relaxed);
+    snap.writeCount = _writeCount.load(std::memory_order_relaxed);
+    snap.maxWriteBlockUs = _maxWriteBlockUs.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        snap.writeLatencyHistogram[i] = _histogram[i].load(std::memory_order_relaxed);
+    }
+    return snap;
+}
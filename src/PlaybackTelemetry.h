@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * PlaybackTelemetry - output health counters fed from task and ISR side
+ *
+ * The writer reports every chunk it queues (onQueued / recordWrite); the I2S
+ * TX interrupt reports every DMA descriptor sent (onSent) and every queue
+ * overflow. Comparing the two detects underruns: a descriptor leaving with
+ * less application data than its size means the driver padded it with
+ * silence. Starvation after markIdle() is intentional silence, not an
+ * underrun, and each starvation episode is counted once.
+ *
+ * All counters are 32-bit atomics updated with read-modify-write operations,
+ * so the ISR side is lock-free and several producer tasks may write at once.
+ * There is no ESP-IDF dependency, so the ISR logic can be driven and checked
+ * on Linux.
+ */
+class PlaybackTelemetry {
+public:
+    static const size_t LATENCY_BUCKETS = 8;
+    static const uint32_t FIRST_BUCKET_US = 250;  // Bucket i holds writes below 250us << i, last is open
+
+    struct Snapshot {
+        uint32_t framesSent;        // Application frames that reached the DMA
+        uint32_t underruns;         // Starvation episodes while streaming
+        uint32_t queueOverflows;    // Driver send queue overflows
+        uint32_t writeCount;        // Number of timed writes
+        uint32_t maxWriteBlockUs;   // Longest time a single write blocked
+        uint32_t writeLatencyHistogram[LATENCY_BUCKETS];
+    };
+
+    PlaybackTelemetry();
+
+    /**
+     * Set frame size used to convert bytes to frames
+     *
+     * @param frameBytes Bytes per frame (all channels)
+     */
+    void setFrameBytes(size_t frameBytes);
+
+    /**
+     * Reset all counters
+     */
+    void reset();
+
+    /**
+     * Task side: record bytes accepted by the driver
+     *
+     * @param bytes Bytes queued
+     */
+    void onQueued(size_t bytes);
+
+    /**
+     * Task side: record how long a write call blocked
+     *
+     * @param blockedUs Blocking time in microseconds
+     */
+    void recordWrite(uint32_t blockedUs);
+
+    /**
+     * Task side: the producer stopped on purpose, following silence is not an underrun
+     */
+    void markIdle();
+
+    /**
+     * ISR side: a DMA descriptor was sent
+     *
+     * @param bytes Descriptor size in bytes
+     * @return true if this descriptor started an underrun
+     */
+    bool onSent(size_t bytes);
+
+    /**
+     * ISR side: the driver's send queue overflowed
+     */
+    void onQueueOverflow();
+
+    /**
+     * Get a consistent-enough copy of all counters
+     *
+     * @return Counter snapshot
+     */
+    Snapshot snapshot() const;
+
+private:
+    uint32_t _frameBytes;
+    std::atomic<uint32_t> _queuedBytes;   // Written by task
+    std::atomic<uint32_t> _sentBytes;     // Written by ISR
+    std::atomic<uint32_t> _underruns;
+    std::atomic<uint32_t> _queueOverflows;
+    std::atomic<bool> _idle;
+    std::atomic<bool> _starved;
+    std::atomic<uint32_t> _writeCount;
+    std::atomic<uint32_t> _maxWriteBlockUs;
+    std::atomic<uint32_t> _histogram[LATENCY_BUCKETS];
+};
@@ -0,0 +1,231 @@
+#include "PrefetchByteSource.h"
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+PrefetchByteSource::PrefetchByteSource()
+    : _upstream(nullptr), _storage(nullptr), _storageSize(0), _allocationCount(0), _blockSize(DEFAULT_BLOCK_SIZE),
+      _size(0), _position(0), _seekable(false), _stats(), _task(nullptr), _stopped(nullptr),
+      _running(false), _upstreamEnd(false), _seekRequested(0), _seekServiced(0), _seekTarget(0) {
+}
+
+PrefetchByteSource::~PrefetchByteSource() {
+    end();
+
+    if (_storage) {
+        heap_caps_free(_storage);
+        _storage = nullptr;
+    }
+
+    if (_stopped) {
+        vSemaphoreDelete(_stopped);
+    }
+}
+
+bool PrefetchByteSource::begin(ByteSource* upstream, size_t blockSize, size_t depth) {
+    if (!upstream || _task) {
+        return false;
+    }
+
+    if (!_stopped) {
+        _stopped = xSemaphoreCreateBinary();
+        if (!_stopped) {
+            return false;
+        }
+    }
+
+    // The ring capacity (block * depth) must be a power of two
+    size_t block = 64;
+    while (block * 2 <= blockSize) {
+        block *= 2;
+    }
+    size_t blocks = 2;
+    while (blocks < depth) {
+        blocks *= 2;
+    }
+
+    size_t storageSize = block * blocks;
+    if (storageSize != _storageSize) {
+        if (_storage) {
+            heap_caps_free(_storage);
+        }
+        _storage = (uint8_t*)heap_caps_malloc(storageSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
+        _storageSize = _storage ? storageSize : 0;
+        if (!_storage) {
+            return false;
+        }
+        _allocationCount++;
+    }
+    _ring.attach(_storage, _storageSize);
+
+    _upstream = upstream;
+    _blockSize = block;
+    _size = upstream->size();
+    _position = upstream->position();
+    _seekable = upstream->isSeekable();
+    _stats = Stats();
+    _upstreamEnd.store(upstream->isEnd(), std::memory_order_release);
+    _seekServiced.store(_seekRequested.load(std::memory_order_relaxed), std::memory_order_release);
+    _running = true;
+
+    if (xTaskCreate(prefetchTask, "prefetch", TASK_STACK, this, TASK_PRIORITY,
+                    (TaskHandle_t*)&_task) != pdPASS) {
+        _task = nullptr;
+        _running = false;
+        _upstream = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void PrefetchByteSource::end() {
+    if (_task) {
+        _running = false;
+        xTaskNotifyGive(_task);
+
+        // An upstream read in progress finishes first; the upstream must not
+        // be released under it, however slow the card is
+        while (xSemaphoreTake(_stopped, pdMS_TO_TICKS(END_TIMEOUT_MS)) != pdTRUE) {
+            Serial.printf("Prefetch: waiting for an upstream read to finish\n");
+        }
+    }
+
+    _upstream = nullptr;
+    _ring.reset();
+    _size = 0;
+    _position = 0;
+}
+
+PrefetchByteSource::Stats PrefetchByteSource::getStats() const {
+    return _stats;
+}
+
+void PrefetchByteSource::resetStats() {
+    _stats = Stats();
+}
+
+size_t PrefetchByteSource::read(uint8_t* buffer, size_t length) {
+    if (!buffer || length == 0 || !_task) {
+        return 0;
+    }
+
+    // Data from before a seek is being discarded
+    if (seekPending()) {
+        _stats.misses++;
+        return 0;
+    }
+
+    // Check for the end before reading, so data committed before it is counted
+    bool ended = _upstreamEnd.load(std::memory_order_acquire);
+    size_t count = _ring.read(buffer, length);
+    _position += count;
+
+    if (count == length) {
+        _stats.hits++;
+    } else if (!ended) {
+        _stats.misses++;
+    }
+
+    if (_ring.space() >= _blockSize) {
+        xTaskNotifyGive(_task);
+    }
+    return count;
+}
+
+bool PrefetchByteSource::seek(size_t position) {
+    if (!_task || !_seekable || (_size && position > _size)) {
+        return false;
+    }
+
+    // A target inside the prefetched window is reached by skipping ahead
+    if (!seekPending() && position >= _position &&
+        position - _position <= _ring.available()) {
+        size_t skip = position - _position;
+        while (skip > 0) {
+            size_t region = 0;
+            _ring.readRegion(&region);
+            size_t n = _min(region, skip);
+            _ring.commitRead(n);
+            skip -= n;
+        }
+        _position = position;
+        xTaskNotifyGive(_task);
+        return true;
+    }
+
+    // Otherwise the task drops the ring and restarts at the target
+    _seekTarget.store(position, std::memory_order_relaxed);
+    _position = position;
+    _seekRequested.fetch_add(1, std::memory_order_release);
+    _stats.seeks++;
+    xTaskNotifyGive(_task);
+    return true;
+}
+
+size_t PrefetchByteSource::available() const {
+    if (seekPending()) {
+        return 0;
+    }
+    return _ring.available();
+}
+
+bool PrefetchByteSource::isEnd() const {
+    if (!_task) {
+        return true;
+    }
+    return !seekPending() &&
+           _upstreamEnd.load(std::memory_order_acquire) && _ring.available() == 0;
+}
+
+void PrefetchByteSource::prefetchTask(void* param) {
+    PrefetchByteSource* self = static_cast<PrefetchByteSource*>(param);
+
+    while (self->_running) {
+        // The consumer does not read while a seek is pending, so the ring
+        // can be reset from this side. Only the request read here is marked
+        // done: a seek issued meanwhile stays pending and is serviced next.
+        uint32_t request = self->_seekRequested.load(std::memory_order_acquire);
+        if (request != self->_seekServiced.load(std::memory_order_relaxed)) {
+            self->_ring.reset();
+            bool sought = self->_upstream->seek(self->_seekTarget.load(std::memory_order_relaxed));
+            self->_upstreamEnd.store(!sought || self->_upstream->isEnd(), std::memory_order_release);
+            self->_seekServiced.store(request, std::memory_order_release);
+            continue;
+        }
+
+        if (self->_upstreamEnd.load(std::memory_order_acquire) || self->_ring.space() < self->_blockSize) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(IDLE_WAIT_MS));
+            continue;
+        }
+
+        size_t region = 0;
+        uint8_t* dst = self->_ring.writeRegion(&region);
+        size_t length = _min(region, self->_blockSize);
+
+        int64_t start = esp_timer_get_time();
+        size_t bytesRead = self->_upstream->read(dst, length);
+        uint32_t elapsedUs = (uint32_t)(esp_timer_get_time() - start);
+        if (elapsedUs > self->_stats.maxReadUs) {
+            self->_stats.maxReadUs = elapsedUs;
+        }
+
+        // A seek requested during the read makes this data stale
+        if (self->seekPending()) {
+            continue;
+        }
+
+        if (bytesRead > 0) {
+            self->_ring.commitWrite(bytesRead);
+            self->_stats.blocksRead++;
+        }
+        if (self->_upstream->isEnd()) {
+            self->_upstreamEnd.store(true, std::memory_order_release);
+        } else if (bytesRead == 0) {
+            // Live upstream has nothing yet
+            vTaskDelay(pdMS_TO_TICKS(1));
+        }
+    }
+
+    self->_task = nullptr;
+    xSemaphoreGive(self->_stopped);
+    vTaskDelete(nullptr);
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "ByteSource.h"
+
+/**
+ * Source that reads another source ahead on its own task
+ *
+ * A prefetch task reads the upstream source (a file on flash or SD) in
+ * blocks into a ring of depth blocks, so read() only copies from memory
+ * and a slow upstream read (flash garbage collection, bus contention)
+ * is absorbed by the read-ahead instead of delaying the decoder.
+ *
+ * read() never waits: when the prefetched data runs short it returns what
+ * is there (possibly 0, counted as a miss) and the caller retries later.
+ * seek() inside the prefetched window just skips ahead; other seeks
+ * restart the prefetch at the new position in the background.
+ *
+ * One task reads and one task consumes, as with the other ring sources.
+ */
+class PrefetchByteSource : public ByteSource {
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 4096;  // Upstream read size (flash sector / LittleFS block)
+    static const size_t DEFAULT_DEPTH = 2;          // Blocks read ahead (double buffer)
+    static const uint32_t TASK_STACK = 3072;
+    static const UBaseType_t TASK_PRIORITY = 4;     // Below the decoder task
+
+    struct Stats {
+        uint32_t hits;        // Reads served entirely from prefetched data
+        uint32_t misses;      // Reads that found less data than requested before the end
+        uint32_t blocksRead;  // Upstream reads made by the prefetch task
+        uint32_t maxReadUs;   // Longest single upstream read
+        uint32_t seeks;       // Seeks that restarted the prefetch
+    };
+
+    PrefetchByteSource();
+    ~PrefetchByteSource();
+
+    /**
+     * Start reading a source ahead
+     *
+     * The buffer is kept across end() and reused while its size stays the same.
+     *
+     * @param upstream Source to read (not owned, used by the prefetch task until end())
+     * @param blockSize Bytes per upstream read, rounded down to a power of two
+     * @param depth Blocks to read ahead, rounded up to a power of two (at least 2)
+     * @return true if the prefetch task was started
+     */
+    bool begin(ByteSource* upstream, size_t blockSize = DEFAULT_BLOCK_SIZE, size_t depth = DEFAULT_DEPTH);
+
+    /**
+     * Stop the prefetch task and release the upstream source
+     *
+     * Blocks until the task has finished any upstream read in progress,
+     * so the upstream can be closed right after.
+     */
+    void end();
+
+    /**
+     * Check if a source is being prefetched
+     *
+     * @return true between begin() and end()
+     */
+    bool isActive() const { return _task != nullptr; }
+
+    /**
+     * Get the size of the read-ahead buffer
+     * 
+     * @return Bytes allocated, 0 before the first begin()
+     */
+    size_t getBufferSize() const { return _storage ? _storageSize : 0; }
+
+    /**
+     * Get the number of buffers allocated by begin()
+     * 
+     * @return Allocations since construction
+     */
+    size_t getAllocationCount() const { return _allocationCount; }
+
+    /**
+     * Get prefetch counters
+     *
+     * @return Counters since begin() or the last reset
+     */
+    Stats getStats() const;
+
+    /**
+     * Reset prefetch counters
+     */
+    void resetStats();
+
+    size_t read(uint8_t* buffer, size_t length) override;
+    bool seek(size_t position) override;
+    size_t size() const override { return _size; }
+    size_t position() const override { return _position; }
+    size_t available() const override;
+    bool isEnd() const override;
+    bool isSeekable() const override { return _seekable; }
+
+private:
+    static const uint32_t IDLE_WAIT_MS = 20;
+    static const uint32_t END_TIMEOUT_MS = 2000;
+
+    ByteSource* _upstream;
+    ByteRingBuffer _ring;
+    uint8_t* _storage;
+    size_t _storageSize;
+    size_t _allocationCount;
+    size_t _blockSize;
+    size_t _size;
+    size_t _position;
+    bool _seekable;
+    Stats _stats;
+
+    TaskHandle_t volatile _task;
+    SemaphoreHandle_t _stopped;               // Given by the task once it no longer touches the upstream
+    volatile bool _running;
+    std::atomic<bool> _upstreamEnd;
+    std::atomic<uint32_t> _seekRequested;     // Incremented by seek()
+    std::atomic<uint32_t> _seekServiced;      // Last request the task has carried out
+    std::atomic<size_t> _seekTarget;
+
+    /**
+     * Check if a seek is waiting for the prefetch task
+     *
+     * @return true until the task has serviced the latest seek
+     */
+    bool seekPending() const {
+        return _seekRequested.load(std::memory_order_acquire) !=
+               _seekServiced.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Prefetch task: keeps the ring filled from the upstream source
+     */
+    static void prefetchTask(void* param);
+};
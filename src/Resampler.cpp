@@ -0,0 +1,226 @@
+#include "Resampler.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t greatestCommonDivisor(uint32_t a, uint32_t b) {
+    while (b != 0) {
+        uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    double halfX = x * 0.5;
+    for (int k = 1; k < 32; k++) {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+static inline int16_t saturate16(int32_t value) {
+    if (value > 32767) {
+        return 32767;
+    }
+    if (value < -32768) {
+        return -32768;
+    }
+    return (int16_t)value;
+}
+
+Resampler::Resampler()
+    : _interpolation(1), _decimation(1), _channels(1), _taps(QUALITY_MEDIUM),
+      _coefficients(nullptr), _coefficientCapacity(0), _allocationCount(0), _historyIndex(0), _phase(0), _pending(1) {
+    reset();
+}
+
+Resampler::~Resampler() {
+    free(_coefficients);
+}
+
+bool Resampler::configure(uint32_t inRate, uint32_t outRate, size_t channels, Quality quality) {
+    if (inRate == 0 || outRate == 0 || channels == 0 || channels > MAX_CHANNELS) {
+        return false;
+    }
+
+    uint32_t divisor = greatestCommonDivisor(inRate, outRate);
+    uint32_t interpolation = outRate / divisor;
+    uint32_t decimation = inRate / divisor;
+    if (interpolation > MAX_PHASES) {
+        return false;
+    }
+
+    _interpolation = interpolation;
+    _decimation = decimation;
+    _channels = channels;
+
+    // Keep the transition band as wide in output samples when decimating
+    size_t scale = (_decimation + _interpolation - 1) / _interpolation;
+    _taps = (size_t)quality * ((scale > 1) ? scale : 1);
+    if (_taps > MAX_TAPS) {
+        _taps = MAX_TAPS;
+    }
+    reset();
+
+    if (isPassthrough()) {
+        return true;
+    }
+
+    size_t needed = (size_t)_interpolation * _taps;
+    if (needed > _coefficientCapacity) {
+        free(_coefficients);
+        _coefficients = (int16_t*)malloc(needed * sizeof(int16_t));
+        if (!_coefficients) {
+            _coefficientCapacity = 0;
+            _interpolation = _decimation = 1;
+            return false;
+        }
+        _coefficientCapacity = needed;
+        _allocationCount++;
+    }
+
+    // Passband edge as a fraction of the lower Nyquist frequency, and the
+    // Kaiser window shape (higher beta: deeper stopband, wider transition)
+    float rolloff;
+    float beta;
+    switch (quality) {
+        case QUALITY_LOW:
+            rolloff = 0.80f;
+            beta = 5.0f;
+            break;
+        case QUALITY_HIGH:
+            rolloff = 0.94f;
+            beta = 8.6f;
+            break;
+        default:
+            rolloff = 0.90f;
+            beta = 7.0f;
+            break;
+    }
+
+    float ratio = (_interpolation < _decimation) ? (float)_interpolation / _decimation : 1.0f;
+    buildCoefficients(0.5f * ratio * rolloff, beta);
+    return true;
+}
+
+void Resampler::buildCoefficients(float cutoff, float beta) {
+    const size_t length = (size_t)_interpolation * _taps;
+    const double center = (length - 1) * 0.5;
+    const double fc = (double)cutoff / _interpolation;  // Cycles per sample at the upsampled rate
+    const double windowNorm = besselI0(beta);
+
+    for (uint32_t p = 0; p < _interpolation; p++) {
+        double phase[MAX_TAPS];
+        double sum = 0.0;
+
+        // Phase p holds prototype taps p, p + L, p + 2L, ...
+        for (size_t k = 0; k < _taps; k++) {
+            double n = (double)(k * _interpolation + p);
+            double x = n - center;
+            double sinc = (x == 0.0) ? 1.0 : sin(2.0 * M_PI * fc * x) / (2.0 * M_PI * fc * x);
+            double r = x / (center + 0.5);
+            double window = besselI0(beta * sqrt(fmax(0.0, 1.0 - r * r))) / windowNorm;
+            phase[k] = sinc * window;
+            sum += phase[k];
+        }
+
+        // Normalize each phase to unity DC gain, then fold the rounding
+        // error into the largest tap so every phase sums to exactly 32768
+        int32_t total = 0;
+        size_t largest = 0;
+        int16_t* dst = _coefficients + p * _taps;
+        for (size_t k = 0; k < _taps; k++) {
+            double scaled = (sum != 0.0) ? phase[k] / sum * 32768.0 : 0.0;
+            dst[k] = saturate16((int32_t)lround(scaled));
+            total += dst[k];
+            if (abs(dst[k]) > abs(dst[largest])) {
+                largest = k;
+            }
+        }
+        dst[largest] = saturate16(dst[largest] + (32768 - total));
+    }
+}
+
+void Resampler::reset() {
+    memset(_history, 0, sizeof(_history));
+    _historyIndex = 0;
+    _phase = 0;
+    _pending = 1;
+}
+
+void Resampler::pushFrame(const int16_t* frame) {
+    _historyIndex = (_historyIndex == 0) ? _taps - 1 : _historyIndex - 1;
+    for (size_t ch = 0; ch < _channels; ch++) {
+        _history[ch][_historyIndex] = frame[ch];
+        _history[ch][_historyIndex + _taps] = frame[ch];
+    }
+}
+
+size_t Resampler::maxOutputFrames(size_t inFrames) const {
+    return (size_t)(((uint64_t)inFrames * _interpolation + _decimation - 1) / _decimation) + 1;
+}
+
+size_t Resampler::process(const int16_t* in, size_t inFrames, int16_t* out, size_t outFrames,
+                          size_t* consumedFrames) {
+    size_t consumed = 0;
+    size_t produced = 0;
+
+    if (!in || !out) {
+        if (consumedFrames) {
+            *consumedFrames = 0;
+        }
+        return 0;
+    }
+
+    if (isPassthrough()) {
+        size_t frames = (inFrames < outFrames) ? inFrames : outFrames;
+        memcpy(out, in, frames * _channels * sizeof(int16_t));
+        if (consumedFrames) {
+            *consumedFrames = frames;
+        }
+        return frames;
+    }
+
+    while (produced < outFrames) {
+        while (_pending > 0 && consumed < inFrames) {
+            pushFrame(in + consumed * _channels);
+            consumed++;
+            _pending--;
+        }
+        if (_pending > 0) {
+            break;  // Input used up before the next output frame
+        }
+
+        // Coefficient magnitudes of a phase can sum to just over 2.0, so a
+        // worst-case full-scale input would overflow an int32 accumulator
+        const int16_t* coefficients = _coefficients + _phase * _taps;
+        for (size_t ch = 0; ch < _channels; ch++) {
+            const int16_t* window = &_history[ch][_historyIndex];
+            int64_t acc = 1 << 14;
+            for (size_t k = 0; k < _taps; k++) {
+                acc += (int32_t)coefficients[k] * window[k];
+            }
+            acc >>= 15;
+            out[produced * _channels + ch] = (int16_t)((acc > 32767) ? 32767 : (acc < -32768) ? -32768 : acc);
+        }
+        produced++;
+
+        _phase += _decimation;
+        _pending = _phase / _interpolation;
+        _phase %= _interpolation;
+    }
+
+    if (consumedFrames) {
+        *consumedFrames = consumed;
+    }
+    return produced;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Resampler - polyphase FIR sample-rate converter for int16 PCM
+ *
+ * Converts between any two sample rates whose ratio reduces to L/M with
+ * L (interpolation) up to MAX_PHASES, which covers every pair of the usual
+ * 8, 11.025, 16, 22.05, 32, 44.1 and 48 kHz rates. A Kaiser-windowed sinc
+ * prototype is split into L phases of Q15 coefficients; each output frame
+ * is one dot product of one phase against the input history, so the cost
+ * per output sample is the tap count regardless of the ratio.
+ *
+ * The quality setting trades stopband attenuation and passband width for
+ * CPU: it is the number of taps per phase. When downsampling the cutoff
+ * drops below the input Nyquist frequency, so the tap count is scaled by
+ * the decimation ratio to keep the same transition width at the output
+ * rate. History is carried across process() calls, so a stream can be
+ * converted in blocks of any size.
+ *
+ * configure() allocates the coefficient table (reused when the size does
+ * not grow); process() never allocates.
+ */
+class Resampler {
+public:
+    /**
+     * Taps per output sample (before scaling for downsampling)
+     */
+    enum Quality {
+        QUALITY_LOW = 8,      // ~60 dB SNR, 80% passband: voice prompts and UI sounds
+        QUALITY_MEDIUM = 16,  // ~80 dB SNR, 90% passband: music
+        QUALITY_HIGH = 32     // ~80 dB SNR, 94% passband: music on a DAC
+    };
+
+    static const size_t MAX_CHANNELS = 2;
+    static const size_t MAX_TAPS = 128;
+    static const uint32_t MAX_PHASES = 2048;
+
+    Resampler();
+    ~Resampler();
+
+    /**
+     * Set up conversion between two rates and reset state
+     *
+     * @param inRate Input sample rate in Hz
+     * @param outRate Output sample rate in Hz
+     * @param channels Interleaved channel count (1 or 2)
+     * @param quality Taps per phase
+     * @return true if the ratio is supported and the table was allocated
+     */
+    bool configure(uint32_t inRate, uint32_t outRate, size_t channels, Quality quality = QUALITY_MEDIUM);
+
+    /**
+     * Clear the input history (call between streams)
+     */
+    void reset();
+
+    /**
+     * Resample a block of interleaved frames
+     *
+     * Stops when the input is consumed or the output is full, whichever
+     * comes first.
+     *
+     * @param in Input frames
+     * @param inFrames Number of input frames
+     * @param out Output buffer
+     * @param outFrames Output capacity in frames
+     * @param consumedFrames Output for number of input frames used
+     * @return Number of output frames produced
+     */
+    size_t process(const int16_t* in, size_t inFrames, int16_t* out, size_t outFrames,
+                   size_t* consumedFrames);
+
+    /**
+     * Check whether input and output rates are equal (process() copies)
+     */
+    bool isPassthrough() const { return _interpolation == _decimation; }
+
+    uint32_t getInterpolation() const { return _interpolation; }
+    uint32_t getDecimation() const { return _decimation; }
+    size_t getTaps() const { return _taps; }
+    size_t getAllocationCount() const { return _allocationCount; }  // Tables allocated by configure()
+
+    /**
+     * Upper bound of output frames for a given number of input frames
+     *
+     * @param inFrames Number of input frames
+     * @return Maximum output frames process() can produce from them
+     */
+    size_t maxOutputFrames(size_t inFrames) const;
+
+private:
+    uint32_t _interpolation;   // L
+    uint32_t _decimation;      // M
+    size_t _channels;
+    size_t _taps;
+    int16_t* _coefficients;    // L phases x taps, Q15, phase-major
+    size_t _coefficientCapacity;
+    size_t _allocationCount;
+
+    // Delay line per channel, written twice so a window of _taps samples
+    // (newest first) is always contiguous at _history[ch][_historyIndex]
+    int16_t _history[MAX_CHANNELS][2 * MAX_TAPS];
+    size_t _historyIndex;
+
+    uint32_t _phase;           // Output position between input frames, in 1/L
+    uint32_t _pending;         // Input frames to push before the next output
+
+    /**
+     * Build the Kaiser-windowed sinc prototype and split it into phases
+     */
+    void buildCoefficients(float cutoff, float beta);
+
+    /**
+     * Push one interleaved input frame into the delay lines
+     */
+    void pushFrame(const int16_t* frame);
+};
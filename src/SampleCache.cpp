@@ -0,0 +1,204 @@
+#include "SampleCache.h"
+#include <esp_heap_caps.h>
+
+SampleCache::SampleCache(size_t budgetBytes)
+    : _budget(budgetBytes), _used(0), _tick(0), _hits(0), _misses(0), _evictions(0) {
+    for (size_t i = 0; i < MAX_ENTRIES; i++) {
+        _entries[i].pcm = nullptr;
+        _entries[i].frames = 0;
+    }
+}
+
+SampleCache::~SampleCache() {
+    clear();
+}
+
+void SampleCache::setBudget(size_t budgetBytes) {
+    _budget = budgetBytes;
+    while (_used > _budget && evictOldest()) {
+    }
+}
+
+size_t SampleCache::entryBytes(const Entry& entry) {
+    return entry.frames * entry.channels * sizeof(int16_t);
+}
+
+size_t SampleCache::indexOf(uint32_t id, uint32_t sampleRate, size_t channels) const {
+    for (size_t i = 0; i < MAX_ENTRIES; i++) {
+        const Entry& entry = _entries[i];
+        if (entry.pcm && entry.id == id && entry.sampleRate == sampleRate && entry.channels == channels) {
+            return i;
+        }
+    }
+    return MAX_ENTRIES;
+}
+
+const int16_t* SampleCache::find(uint32_t id, uint32_t sampleRate, size_t channels, size_t* frames) {
+    size_t index = indexOf(id, sampleRate, channels);
+    if (index == MAX_ENTRIES) {
+        _misses++;
+        return nullptr;
+    }
+
+    Entry& entry = _entries[index];
+    entry.lastUse = ++_tick;
+    _hits++;
+    if (frames) {
+        *frames = entry.frames;
+    }
+    return entry.pcm;
+}
+
+bool SampleCache::contains(uint32_t id, uint32_t sampleRate, size_t channels) const {
+    return indexOf(id, sampleRate, channels) != MAX_ENTRIES;
+}
+
+bool SampleCache::insert(uint32_t id, uint32_t sampleRate, size_t channels, int16_t* pcm, size_t frames) {
+    size_t bytes = frames * channels * sizeof(int16_t);
+    if (!pcm || frames == 0 || bytes > _budget) {
+        return false;
+    }
+
+    // A clip re-rendered for the same key replaces the old one
+    size_t existing = indexOf(id, sampleRate, channels);
+    if (existing != MAX_ENTRIES) {
+        freeEntry(_entries[existing]);
+    }
+
+    // Make room within the budget, oldest clips first
+    while (_used + bytes > _budget && evictOldest()) {
+    }
+
+    Entry* slot = nullptr;
+    for (size_t i = 0; i < MAX_ENTRIES && !slot; i++) {
+        if (!_entries[i].pcm) {
+            slot = &_entries[i];
+        }
+    }
+    if (!slot) {
+        evictOldest();
+        for (size_t i = 0; i < MAX_ENTRIES && !slot; i++) {
+            if (!_entries[i].pcm) {
+                slot = &_entries[i];
+            }
+        }
+    }
+
+    slot->id = id;
+    slot->sampleRate = sampleRate;
+    slot->channels = channels;
+    slot->pcm = pcm;
+    slot->frames = frames;
+    slot->lastUse = ++_tick;
+    _used += bytes;
+    return true;
+}
+
+bool SampleCache::evictOldest() {
+    Entry* oldest = nullptr;
+    for (size_t i = 0; i < MAX_ENTRIES; i++) {
+        Entry& entry = _entries[i];
+        if (entry.pcm && (!oldest || entry.lastUse < oldest->lastUse)) {
+            oldest = &entry;
+        }
+    }
+
+    if (!oldest) {
+        return false;
+    }
+
+    freeEntry(*oldest);
+    _evictions++;
+    return true;
+}
+
+void SampleCache::freeEntry(Entry& entry) {
+    if (entry.pcm) {
+        _used -= entryBytes(entry);
+        heap_caps_free(entry.pcm);
+        entry.pcm = nullptr;
+        entry.frames = 0;
+    }
+}
+
+void SampleCache::clear() {
+    for (size_t i = 0; i < MAX_ENTRIES; i++) {
+        freeEntry(_entries[i]);
+    }
+}
+
+SampleCache::Stats SampleCache::getStats() const {
+    Stats stats;
+    stats.hits = _hits;
+    stats.misses = _misses;
+    stats.evictions = _evictions;
+    stats.usedBytes = _used;
+    stats.entries = 0;
+    for (size_t i = 0; i < MAX_ENTRIES; i++) {
+        if (_entries[i].pcm) {
+            stats.entries++;
+        }
+    }
+    return stats;
+}
+
+MemoryAudioSink::MemoryAudioSink(uint32_t sampleRate, size_t channels)
+    : _sampleRate(sampleRate), _channels(channels > 0 ? channels : 1),
+      _buffer(nullptr), _length(0), _capacity(0) {
+}
+
+MemoryAudioSink::~MemoryAudioSink() {
+    if (_buffer) {
+        heap_caps_free(_buffer);
+    }
+}
+
+void* MemoryAudioSink::acquireBuffer(size_t* capacity, uint32_t timeoutMs) {
+    (void)timeoutMs;
+
+    // Grow geometrically so a clip costs O(log n) reallocations
+    size_t slotSamples = SLOT_FRAMES * _channels;
+    if (_length + slotSamples > _capacity) {
+        size_t newCapacity = _max(_capacity * 2, _length + slotSamples);
+        int16_t* grown = (int16_t*)heap_caps_realloc(_buffer, newCapacity * sizeof(int16_t),
+                                                     MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
+        if (!grown) {
+            return nullptr;
+        }
+        _buffer = grown;
+        _capacity = newCapacity;
+    }
+
+    if (capacity) {
+        *capacity = slotSamples * sizeof(int16_t);
+    }
+    return _buffer + _length;
+}
+
+bool MemoryAudioSink::commitBuffer(size_t bytes, uint32_t timeoutMs) {
+    (void)timeoutMs;
+
+    size_t samples = bytes / sizeof(int16_t);
+    samples -= samples % _channels;
+    if (_length + samples > _capacity) {
+        return false;
+    }
+    _length += samples;
+    return true;
+}
+
+int16_t* MemoryAudioSink::release() {
+    if (!_buffer || _length == 0) {
+        return nullptr;
+    }
+
+    // Trim the growth slack; keep the larger buffer if shrinking fails
+    int16_t* trimmed = (int16_t*)heap_caps_realloc(_buffer, _length * sizeof(int16_t),
+                                                   MALLOC_CAP_SPIRAM | MALLOC_CAP_DEFAULT);
+    int16_t* result = trimmed ? trimmed : _buffer;
+
+    _buffer = nullptr;
+    _length = 0;
+    _capacity = 0;
+    return result;
+}
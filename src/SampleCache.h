@@ -0,0 +1,186 @@
+#pragma once
+
+#include <Arduino.h>
+#include "AudioSink.h"
+
+/**
+ * SampleCache - pre-rendered PCM clips in PSRAM with LRU eviction
+ *
+ * Holds fully rendered sound presets keyed by preset id, sample rate and
+ * channel count, so a repeated UI sound is played from memory instead of
+ * being synthesized again. The total size of all clips is kept within a
+ * byte budget; when a new clip does not fit, the least recently played
+ * clips are evicted first.
+ *
+ * Not thread-safe: use from the task that plays the sounds.
+ */
+class SampleCache {
+public:
+    static const size_t MAX_ENTRIES = 32;
+
+    /**
+     * Cache counters
+     */
+    struct Stats {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t evictions;
+        size_t usedBytes;
+        size_t entries;
+    };
+
+    /**
+     * Constructor
+     *
+     * @param budgetBytes Memory budget for all clips (0 disables the cache)
+     */
+    SampleCache(size_t budgetBytes = 0);
+
+    /**
+     * Destructor - frees all clips
+     */
+    ~SampleCache();
+
+    /**
+     * Change the memory budget, evicting clips that no longer fit
+     *
+     * @param budgetBytes Memory budget for all clips (0 disables the cache)
+     */
+    void setBudget(size_t budgetBytes);
+
+    size_t getBudget() const { return _budget; }
+    bool isEnabled() const { return _budget > 0; }
+
+    /**
+     * Look up a clip and mark it as recently used
+     *
+     * The pointer stays valid until the clip is evicted by a later insert(),
+     * setBudget() or clear().
+     *
+     * @param id Preset id
+     * @param sampleRate Sample rate the clip was rendered at
+     * @param channels Channels the clip was rendered with
+     * @param frames Output for clip length in frames
+     * @return Clip samples, or nullptr on a miss
+     */
+    const int16_t* find(uint32_t id, uint32_t sampleRate, size_t channels, size_t* frames);
+
+    /**
+     * Check for a clip without touching its use order or the counters
+     *
+     * @param id Preset id
+     * @param sampleRate Sample rate the clip was rendered at
+     * @param channels Channels the clip was rendered with
+     * @return true if the clip is cached
+     */
+    bool contains(uint32_t id, uint32_t sampleRate, size_t channels) const;
+
+    /**
+     * Add a clip, evicting least recently used clips to make room
+     *
+     * On success the cache takes ownership of pcm (allocated with
+     * heap_caps_malloc); on failure the caller keeps it.
+     *
+     * @param id Preset id
+     * @param sampleRate Sample rate the clip was rendered at
+     * @param channels Channels the clip was rendered with
+     * @param pcm Interleaved samples
+     * @param frames Clip length in frames
+     * @return true if the clip was added
+     */
+    bool insert(uint32_t id, uint32_t sampleRate, size_t channels, int16_t* pcm, size_t frames);
+
+    /**
+     * Free all clips
+     */
+    void clear();
+
+    /**
+     * Get cache counters
+     *
+     * @return Counter snapshot
+     */
+    Stats getStats() const;
+
+private:
+    struct Entry {
+        uint32_t id;
+        uint32_t sampleRate;
+        size_t channels;
+        int16_t* pcm;           // nullptr for an empty entry
+        size_t frames;
+        uint32_t lastUse;       // Use tick, lower is older
+    };
+
+    Entry _entries[MAX_ENTRIES];
+    size_t _budget;
+    size_t _used;
+    uint32_t _tick;
+    uint32_t _hits;
+    uint32_t _misses;
+    uint32_t _evictions;
+
+    static size_t entryBytes(const Entry& entry);
+
+    /**
+     * Find the entry holding a clip
+     *
+     * @return Entry index, or MAX_ENTRIES if the clip is not cached
+     */
+    size_t indexOf(uint32_t id, uint32_t sampleRate, size_t channels) const;
+
+    /**
+     * Evict the least recently used clip
+     *
+     * @return false if the cache is empty
+     */
+    bool evictOldest();
+
+    void freeEntry(Entry& entry);
+};
+
+/**
+ * AudioSink that records committed PCM into a growing PSRAM buffer
+ *
+ * Used to render presets offline for the cache: producers that normally
+ * write to the speaker can render into it unchanged.
+ */
+class MemoryAudioSink : public AudioSink {
+public:
+    static const size_t SLOT_FRAMES = 256;
+
+    /**
+     * @param sampleRate Sample rate reported to producers
+     * @param channels Channels reported to producers
+     */
+    MemoryAudioSink(uint32_t sampleRate, size_t channels);
+
+    /**
+     * Destructor - frees the recording unless it was released
+     */
+    ~MemoryAudioSink();
+
+    void* acquireBuffer(size_t* capacity, uint32_t timeoutMs = 100) override;
+    bool commitBuffer(size_t bytes, uint32_t timeoutMs = 100) override;
+    uint32_t getSampleRate() const override { return _sampleRate; }
+    size_t getChannelCount() const override { return _channels; }
+
+    /**
+     * Get number of frames recorded so far
+     */
+    size_t getFrames() const { return _length / _channels; }
+
+    /**
+     * Hand over the recording (trimmed to size) to the caller
+     *
+     * @return Recorded samples (free with heap_caps_free), or nullptr if empty
+     */
+    int16_t* release();
+
+private:
+    uint32_t _sampleRate;
+    size_t _channels;
+    int16_t* _buffer;
+    size_t _length;     // Samples recorded
+    size_t _capacity;   // Samples allocated
+};
@@ -0,0 +1,137 @@
+#include "SampleConverter.h"
+#include <string.h>
+
+static inline int32_t clampToBits(float value, int32_t maxValue) {
+    if (value >= (float)maxValue) {
+        return maxValue;
+    }
+    if (value <= (float)(-maxValue - 1)) {
+        return -maxValue - 1;
+    }
+    // Round half away from zero
+    return (int32_t)(value + ((value >= 0.0f) ? 0.5f : -0.5f));
+}
+
+static inline void store24(uint8_t* dst, int32_t value) {
+    dst[0] = (uint8_t)(value & 0xFF);
+    dst[1] = (uint8_t)((value >> 8) & 0xFF);
+    dst[2] = (uint8_t)((value >> 16) & 0xFF);
+}
+
+void SampleConverter::expandInt16InPlace(uint8_t* buffer, size_t count, size_t bytesPerSample) {
+    if (!buffer || count == 0 || bytesPerSample <= 2) {
+        return;
+    }
+
+    // Sample i moves from byte 2i to byte i * bytesPerSample (>= 2i), so
+    // walking backwards never clobbers a sample that is still to be read
+    size_t i = count;
+
+    if (bytesPerSample == 4) {
+        while (i > 0) {
+            i--;
+            int16_t sample;
+            memcpy(&sample, buffer + i * 2, sizeof(sample));
+            int32_t wide = (int32_t)((uint32_t)(int32_t)sample << 16);
+            memcpy(buffer + i * 4, &wide, sizeof(wide));
+        }
+        return;
+    }
+
+    while (i > 0) {
+        i--;
+        int16_t sample;
+        memcpy(&sample, buffer + i * 2, sizeof(sample));
+        store24(buffer + i * 3, (int32_t)sample * 256);
+    }
+}
+
+void SampleConverter::fromFloat(const float* src, uint8_t* dst, size_t count, size_t bytesPerSample,
+                                Dither* dither, size_t sampleBits) {
+    if (!src || !dst || count == 0) {
+        return;
+    }
+
+    size_t blocks = count / BLOCK_SAMPLES;
+    size_t tail = count % BLOCK_SAMPLES;
+
+    switch (bytesPerSample) {
+        case 4: {
+            if (sampleBits == 24) {
+                // Dithered 24-bit value in the top three bytes of the container
+                float noise[BLOCK_SAMPLES] = {0.0f};
+                int32_t block[BLOCK_SAMPLES];
+                for (size_t b = 0; b <= blocks; b++) {
+                    size_t n = (b < blocks) ? BLOCK_SAMPLES : tail;
+                    if (dither) {
+                        for (size_t i = 0; i < n; i++) {
+                            noise[i] = dither->next();
+                        }
+                    }
+                    for (size_t i = 0; i < n; i++) {
+                        int32_t value = clampToBits(src[i] * 8388608.0f + noise[i], 8388607);
+                        block[i] = (int32_t)((uint32_t)value << 8);
+                    }
+                    memcpy(dst, block, n * sizeof(int32_t));
+                    src += n;
+                    dst += n * sizeof(int32_t);
+                }
+                break;
+            }
+
+            // float has a 24-bit mantissa, so 32-bit output needs no dither
+            int32_t block[BLOCK_SAMPLES];
+            for (size_t b = 0; b < blocks; b++) {
+                for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+                    block[i] = clampToBits(src[i] * 2147483648.0f, 2147483647);
+                }
+                memcpy(dst, block, sizeof(block));
+                src += BLOCK_SAMPLES;
+                dst += sizeof(block);
+            }
+            for (size_t i = 0; i < tail; i++) {
+                int32_t value = clampToBits(src[i] * 2147483648.0f, 2147483647);
+                memcpy(dst + i * 4, &value, sizeof(value));
+            }
+            break;
+        }
+
+        case 3: {
+            float noise[BLOCK_SAMPLES] = {0.0f};
+            for (size_t b = 0; b <= blocks; b++) {
+                size_t n = (b < blocks) ? BLOCK_SAMPLES : tail;
+                if (dither) {
+                    for (size_t i = 0; i < n; i++) {
+                        noise[i] = dither->next();
+                    }
+                }
+                for (size_t i = 0; i < n; i++) {
+                    store24(dst + i * 3, clampToBits(src[i] * 8388608.0f + noise[i], 8388607));
+                }
+                src += n;
+                dst += n * 3;
+            }
+            break;
+        }
+
+        default: {
+            float noise[BLOCK_SAMPLES] = {0.0f};
+            int16_t block[BLOCK_SAMPLES];
+            for (size_t b = 0; b <= blocks; b++) {
+                size_t n = (b < blocks) ? BLOCK_SAMPLES : tail;
+                if (dither) {
+                    for (size_t i = 0; i < n; i++) {
+                        noise[i] = dither->next();
+                    }
+                }
+                for (size_t i = 0; i < n; i++) {
+                    block[i] = (int16_t)clampToBits(src[i] * 32768.0f + noise[i], 32767);
+                }
+                memcpy(dst, block, n * sizeof(int16_t));
+                src += n;
+                dst += n * sizeof(int16_t);
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * SampleConverter - PCM sample format conversion kernels
+ *
+ * Converts int16 and float32 PCM to the I2S slot formats: 16-bit, packed
+ * 24-bit (3 bytes, little endian), 24-bit left-justified in 4 bytes (the
+ * container used by ESP32/ESP32-S2) and 32-bit. Widening int16 is lossless
+ * and can run in place, so a buffer holding int16 samples at its start can
+ * be expanded to the slot width without a second buffer. Narrowing float to
+ * 16 or 24 bits applies TPDF dither.
+ *
+ * Inner loops work on blocks of BLOCK_SAMPLES with no cross-sample
+ * dependency so the compiler can vectorize them.
+ */
+class SampleConverter {
+public:
+    static const size_t BLOCK_SAMPLES = 4;
+
+    /**
+     * TPDF dither state (one per output stream)
+     */
+    struct Dither {
+        uint32_t state;
+
+        Dither(uint32_t seed = 0x9E3779B9u) : state(seed) {}
+
+        /**
+         * Triangular noise in [-1, 1) LSB of the target width
+         */
+        float next() {
+            state = state * 1664525u + 1013904223u;
+            float a = (float)(state >> 8) * (1.0f / 16777216.0f);
+            state = state * 1664525u + 1013904223u;
+            float b = (float)(state >> 8) * (1.0f / 16777216.0f);
+            return a - b;
+        }
+    };
+
+    /**
+     * Expand int16 samples at the start of a buffer to a wider slot format
+     *
+     * Runs back to front so the source is never overwritten before it is
+     * read. The buffer must hold count * bytesPerSample bytes. A 4-byte
+     * target also serves left-justified 24-bit containers.
+     *
+     * @param buffer Buffer holding count int16 samples at its start
+     * @param count Number of samples
+     * @param bytesPerSample Target width in bytes (2, 3 or 4)
+     */
+    static void expandInt16InPlace(uint8_t* buffer, size_t count, size_t bytesPerSample);
+
+    /**
+     * Convert float samples (-1.0 to 1.0) to a slot format
+     *
+     * Out-of-range input saturates. Narrowing to 16 or 24 bits is dithered.
+     *
+     * @param src Input samples
+     * @param dst Output buffer (count * bytesPerSample bytes)
+     * @param count Number of samples
+     * @param bytesPerSample Target width in bytes (2, 3 or 4)
+     * @param dither Dither state, nullptr to truncate without dither
+     * @param sampleBits 24 with bytesPerSample 4 for left-justified 24-bit
+     *                   samples, 0 for the full container width
+     */
+    static void fromFloat(const float* src, uint8_t* dst, size_t count, size_t bytesPerSample,
+                          Dither* dither, size_t sampleBits = 0);
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+/**
+ * Lock-free single-producer/single-consumer ring buffer
+ *
+ * One task may write and one other task may read concurrently without any
+ * lock. Indices run freely and are masked on access, so the capacity must be
+ * a power of two. Storage is supplied by the caller so it can live in PSRAM
+ * on target or on the heap in host-side tests.
+ *
+ * Besides copying read()/write(), the ring exposes its contiguous free and
+ * filled regions so producers and consumers can work in place.
+ */
+template <typename T>
+class SpscRingBuffer {
+public:
+    SpscRingBuffer() : _buffer(nullptr), _capacity(0), _mask(0), _head(0), _tail(0) {}
+
+    /**
+     * Attach caller-owned storage and reset the ring
+     *
+     * @param storage Storage for capacity elements
+     * @param capacity Number of elements, must be a power of two
+     * @return true if the storage was accepted
+     */
+    bool attach(T* storage, size_t capacity) {
+        if (!storage || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            return false;
+        }
+        _buffer = storage;
+        _capacity = capacity;
+        _mask = capacity - 1;
+        reset();
+        return true;
+    }
+
+    /**
+     * Detach storage (ring becomes unusable until attach() is called again)
+     */
+    void detach() {
+        _buffer = nullptr;
+        _capacity = 0;
+        _mask = 0;
+        reset();
+    }
+
+    /**
+     * Drop all buffered elements. Only safe while neither side is active.
+     */
+    void reset() {
+        _head.store(0, std::memory_order_relaxed);
+        _tail.store(0, std::memory_order_relaxed);
+    }
+
+    bool isAttached() const { return _buffer != nullptr; }
+    size_t capacity() const { return _capacity; }
+
+    /**
+     * Number of elements ready to be read (consumer side)
+     */
+    size_t available() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Number of elements that can be written (producer side)
+     */
+    size_t space() const {
+        return _capacity - (_head.load(std::memory_order_relaxed) - _tail.load(std::memory_order_acquire));
+    }
+
+    /**
+     * Copy up to count elements into the ring (producer side)
+     *
+     * @return Number of elements written
+     */
+    size_t write(const T* data, size_t count) {
+        size_t written = 0;
+        while (written < count) {
+            size_t region;
+            T* dst = writeRegion(&region);
+            if (region == 0) {
+                break;
+            }
+            size_t n = (count - written < region) ? count - written : region;
+            memcpy(dst, data + written, n * sizeof(T));
+            commitWrite(n);
+            written += n;
+        }
+        return written;
+    }
+
+    /**
+     * Copy up to count elements out of the ring (consumer side)
+     *
+     * @return Number of elements read
+     */
+    size_t read(T* data, size_t count) {
+        size_t readCount = 0;
+        while (readCount < count) {
+            size_t region;
+            const T* src = readRegion(&region);
+            if (region == 0) {
+                break;
+            }
+            size_t n = (count - readCount < region) ? count - readCount : region;
+            memcpy(data + readCount, src, n * sizeof(T));
+            commitRead(n);
+            readCount += n;
+        }
+        return readCount;
+    }
+
+    /**
+     * Get the contiguous free region at the write position (producer side)
+     *
+     * @param count Output for number of elements in the region
+     * @return Pointer to the region
+     */
+    T* writeRegion(size_t* count) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t free = _capacity - (head - _tail.load(std::memory_order_acquire));
+        size_t index = head & _mask;
+        size_t toEnd = _capacity - index;
+        *count = (free < toEnd) ? free : toEnd;
+        return _buffer + index;
+    }
+
+    /**
+     * Publish count elements written into the region from writeRegion()
+     */
+    void commitWrite(size_t count) {
+        _head.store(_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    /**
+     * Get the contiguous filled region at the read position (consumer side)
+     *
+     * @param count Output for number of elements in the region
+     * @return Pointer to the region
+     */
+    const T* readRegion(size_t* count) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        size_t filled = _head.load(std::memory_order_acquire) - tail;
+        size_t index = tail & _mask;
+        size_t toEnd = _capacity - index;
+        *count = (filled < toEnd) ? filled : toEnd;
+        return _buffer + index;
+    }
+
+    /**
+     * Release count elements consumed from the region from readRegion()
+     */
+    void commitRead(size_t count) {
+        _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+private:
+    T* _buffer;
+    size_t _capacity;
+    size_t _mask;
+    std::atomic<size_t> _head;  // Written by producer only
+    std::atomic<size_t> _tail;  // Written by consumer only
+};
+
+using PcmRingBuffer = SpscRingBuffer<int16_t>;
+using ByteRingBuffer = SpscRingBuffer<uint8_t>;